@@ -5,11 +5,15 @@
 #include <map>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <functional>
 #include <filesystem>
 #include <atomic>
 #include <set>
+#include <deque>
+#include <chrono>
+#include <sys/types.h>
 
 #include <juliett/juliett.hpp>
 #include <lima/lima.hpp>
@@ -28,6 +32,10 @@
 #define BRV_CMD_CLEAN_STR               "clean"
 #define BRV_CMD_INIT_STR                "init"
 #define BRV_CMD_TEST_STR                "test"
+#define BRV_CMD_WATCH_STR               "watch"
+#define BRV_CMD_ANALYZE_STR             "analyze"
+#define BRV_CMD_BENCH_STR               "bench"
+#define BRV_CMD_PGO_STR                 "pgo"
 
 #define BRV_CMD_HELP_USAGE              "Show this message"
 #define BRV_CMD_BUILD_USAGE             "Compile and link the current project"
@@ -35,6 +43,10 @@
 #define BRV_CMD_CLEAN_USAGE             "Remove binary and object file directories"
 #define BRV_CMD_INIT_USAGE              "Create new project in current directory"
 #define BRV_CMD_TEST_USAGE              "Compile, link and run tests"
+#define BRV_CMD_WATCH_USAGE             "Rebuild on file changes and serve builds in the background"
+#define BRV_CMD_ANALYZE_USAGE           "Build with compiler time traces and rank costly headers and templates"
+#define BRV_CMD_BENCH_USAGE             "Time every phase of bravo on a generated tree : [files] [projects] [output]"
+#define BRV_CMD_PGO_USAGE               "Build instrumented, run a training workload and rebuild with its profile"
 
 #define BRV_CMD_HELP_SKIP_CONFIG        true
 #define BRV_CMD_BUILD_SKIP_CONFIG       false
@@ -42,6 +54,10 @@
 #define BRV_CMD_CLEAN_SKIP_CONFIG       true
 #define BRV_CMD_INIT_SKIP_CONFIG        true
 #define BRV_CMD_TEST_SKIP_CONFIG        false
+#define BRV_CMD_WATCH_SKIP_CONFIG       false
+#define BRV_CMD_ANALYZE_SKIP_CONFIG     false
+#define BRV_CMD_BENCH_SKIP_CONFIG       true
+#define BRV_CMD_PGO_SKIP_CONFIG         false
 
 #define BRV_CMD_HELP_NON_OPT_ARGC_MAX   0
 #define BRV_CMD_BUILD_NON_OPT_ARGC_MAX  0
@@ -49,36 +65,104 @@
 #define BRV_CMD_CLEAN_NON_OPT_ARGC_MAX  0
 #define BRV_CMD_INIT_NON_OPT_ARGC_MAX   1
 #define BRV_CMD_TEST_NON_OPT_ARGC_MAX   USHRT_MAX
+#define BRV_CMD_WATCH_NON_OPT_ARGC_MAX  0
+#define BRV_CMD_ANALYZE_NON_OPT_ARGC_MAX 0
+#define BRV_CMD_BENCH_NON_OPT_ARGC_MAX  3
+#define BRV_CMD_PGO_NON_OPT_ARGC_MAX    0
 
 #define BRV_OPT_VERBOSE_STR_LONG        "verbose"
 #define BRV_OPT_DEPS_STR_LONG           "deps"
 #define BRV_OPT_NO_BUILD_STR_LONG       "no-build"
+#define BRV_OPT_JOBS_STR_LONG           "jobs"
+#define BRV_OPT_SHARD_STR_LONG          "shard"
+#define BRV_OPT_TIMEOUT_STR_LONG        "timeout"
+#define BRV_OPT_LOAD_STR_LONG           "load"
+#define BRV_OPT_UNITY_STR_LONG          "unity"
+#define BRV_OPT_TRACE_STR_LONG          "trace"
+#define BRV_OPT_PROFILE_STR_LONG        "profile"
 
 #define BRV_OPT_VERBOSE_STR_SHRT        'v'
 #define BRV_OPT_DEPS_STR_SHRT           'd'
 #define BRV_OPT_NO_BUILD_STR_SHRT       'n'
+#define BRV_OPT_JOBS_STR_SHRT           'j'
+#define BRV_OPT_SHARD_STR_SHRT          's'
+#define BRV_OPT_TIMEOUT_STR_SHRT        't'
+#define BRV_OPT_LOAD_STR_SHRT           'l'
+#define BRV_OPT_UNITY_STR_SHRT          'u'
+#define BRV_OPT_TRACE_STR_SHRT          'r'
+#define BRV_OPT_PROFILE_STR_SHRT        'p'
 
 #define BRV_OPT_VERBOSE_USAGE           "Enable verbose logging"
 #define BRV_OPT_DEPS_USAGE              "Force build all dependencies recursively"
 #define BRV_OPT_NO_BUILD_USAGE          "Skip auto re-build"
+#define BRV_OPT_JOBS_USAGE              "Run at most <n> jobs in parallel"
+#define BRV_OPT_SHARD_USAGE             "Only run test shard <i>/<n>"
+#define BRV_OPT_TIMEOUT_USAGE           "Kill tests running longer than <s> seconds (0 to disable)"
+#define BRV_OPT_LOAD_USAGE              "Start no new jobs while the load average is above <load>"
+#define BRV_OPT_UNITY_USAGE             "Compile sources in batches of 'unity_batch' files"
+#define BRV_OPT_TRACE_USAGE             "Write a Chrome trace of the run to <file>"
+#define BRV_OPT_PROFILE_USAGE           "Build with profile <name>, see 'profiles' (default 'debug')"
 
 #define BRV_OPT_VERBOSE_ID              0
 #define BRV_OPT_DEPS_ID                 1
 #define BRV_OPT_NO_BUILD_ID             2
+#define BRV_OPT_JOBS_ID                 3
+#define BRV_OPT_SHARD_ID                4
+#define BRV_OPT_TIMEOUT_ID              5
+#define BRV_OPT_LOAD_ID                 6
+#define BRV_OPT_UNITY_ID                7
+#define BRV_OPT_TRACE_ID                8
+#define BRV_OPT_PROFILE_ID              9
 
 // INTERNAL DEFINES
 
 #define BRV_FILE_NAME_CONFIG            "bravo.json"
+#define BRV_FILE_NAME_STATE             ".bravo_db"
+#define BRV_FILE_NAME_GRAPH             ".bravo_graph"
+#define BRV_FILE_NAME_SCAN_DB           ".bravo_scan_db.json"
+#define BRV_FILE_NAME_SCAN              ".bravo_scan.json"
 #define BRV_FILE_EXT_CPP                ".cpp"
+#define BRV_FILE_EXT_MODULE             ".cppm"
+#define BRV_FILE_EXT_BMI                ".pcm"
 #define BRV_FILE_EXT_OBJ                ".o"
+#define BRV_FILE_EXT_DEP                ".d"
+#define BRV_FILE_EXT_PRE                ".ii"
+#define BRV_FILE_EXT_PCH                ".pch"
+#define BRV_FILE_EXT_TIME_TRACE         ".json"
+#define BRV_FILE_EXT_PROFRAW            ".profraw"
+#define BRV_FILE_EXT_PROFDATA           ".profdata"
 #define BRV_FILE_EXT_ARCHIVE            ".a"
 #define BRV_FILE_EXT_EXE                ""
 
+#ifdef __APPLE__
+#define BRV_ARCHIVER                    {"libtool", "-static", "-D", "-o"}
+#define BRV_LTO_ARCHIVER                "libtool"
+#define BRV_LINK_GC_SECTIONS            "-Wl,-dead_strip"
+#define BRV_LTO_CACHE_DIR               "-Wl,-cache_path_lto,"
+#define BRV_LTO_THIN_LINKER             "system"
+#define BRV_LTO_THIN_LINKERS            {BRV_LINKER_SYSTEM, BRV_LINKER_LLD}
+#define BRV_LTO_CACHE_POLICY            "-Wl,-prune_interval_lto,3600"
+#define BRV_LINKER_PREFIX               "ld64."
+#define BRV_STAT_MTIME(st)              (st).st_mtimespec
+#else
+#define BRV_ARCHIVER                    {"ar", "rcsD"}
+#define BRV_LTO_ARCHIVER                "llvm-ar"
+#define BRV_LINK_GC_SECTIONS            "-Wl,--gc-sections"
+#define BRV_LTO_CACHE_DIR               "-Wl,--thinlto-cache-dir="
+#define BRV_LTO_THIN_LINKER             "lld"
+#define BRV_LTO_THIN_LINKERS            {BRV_LINKER_LLD}
+#define BRV_LTO_CACHE_POLICY            "-Wl,--thinlto-cache-policy=prune_after=604800s:cache_size=10%"
+#define BRV_LINKER_PREFIX               "ld."
+#define BRV_STAT_MTIME(st)              (st).st_mtim
+#endif
+
 #define BRV_DIR_SRC                     "src"
 #define BRV_DIR_OBJ                     "obj"
 #define BRV_DIR_BIN                     "bin"
 #define BRV_DIR_INCLUDE                 "include"
 #define BRV_DIR_TEST                    "tests"
+#define BRV_DIR_UNITY                   "unity"
+#define BRV_DIR_MODULES                 "modules"
 
 // PARSING DEFINES
 
@@ -88,6 +172,27 @@
 #define BRV_KEY_DEPS                    "deps"
 #define BRV_KEY_BUILD_NAME              "build_name"
 #define BRV_KEY_RUN_ARGS                "run_args"
+#define BRV_KEY_JOBS                    "jobs"
+#define BRV_KEY_MEMORY                  "memory"
+#define BRV_KEY_PCH                     "pch"
+#define BRV_KEY_UNITY_BATCH             "unity_batch"
+#define BRV_KEY_UNITY_EXCLUDE           "unity_exclude"
+#define BRV_KEY_UNITY_GROUP             "unity_group"
+#define BRV_KEY_PROFILES                "profiles"
+#define BRV_KEY_PGO_TRAIN               "pgo_train"
+#define BRV_KEY_LINKER                  "linker"
+
+#define BRV_KEY_PROFILE_INHERITS        "inherits"
+#define BRV_KEY_PROFILE_OPT             "opt"
+#define BRV_KEY_PROFILE_MARCH           "march"
+#define BRV_KEY_PROFILE_LTO             "lto"
+#define BRV_KEY_PROFILE_DEBUG           "debug"
+#define BRV_KEY_PROFILE_GC_SECTIONS     "gc_sections"
+#define BRV_KEY_PROFILE_SPLIT_DEBUG     "split_debug"
+#define BRV_KEY_PROFILE_COMPRESS_DEBUG  "compress_debug"
+#define BRV_KEY_PROFILE_DEFINES         "defines"
+#define BRV_KEY_PROFILE_FLAGS           "flags"
+#define BRV_KEY_PROFILE_LINK_FLAGS      "link_flags"
 
 #define BRV_PROJECT_TYPE_EXEC           "exec"
 #define BRV_PROJECT_TYPE_STATIC         "static"
@@ -96,6 +201,140 @@
 #define BRV_VALIDATION_PROJECT_TYPE     "Type validation"
 #define BRV_VALIDATION_ENTRY            "Entry validation"
 #define BRV_VALIDATION_DEPS             "Deps validation"
+#define BRV_VALIDATION_JOBS             "Jobs validation"
+#define BRV_VALIDATION_MEMORY           "Memory validation"
+#define BRV_VALIDATION_PCH              "Precompiled header validation"
+#define BRV_VALIDATION_UNITY            "Unity validation"
+#define BRV_VALIDATION_PROFILES         "Profiles validation"
+#define BRV_VALIDATION_LINKER           "Linker validation"
+
+// STATE DEFINES
+
+#define BRV_STATE_MAGIC                 0x42445242
+#define BRV_STATE_VERSION               1
+#define BRV_STATE_RACY_MS               2000
+
+// SNAPSHOT DEFINES
+
+#define BRV_SNAPSHOT_MAGIC              0x47445242
+#define BRV_SNAPSHOT_VERSION            8
+
+// PROFILE DEFINES
+
+#define BRV_PROFILE_DEBUG               "debug"
+#define BRV_PROFILE_RELEASE             "release"
+#define BRV_PROFILE_RELWITHDEBINFO      "relwithdebinfo"
+#define BRV_PROFILE_DEFAULT             BRV_PROFILE_DEBUG
+
+// LINKER DEFINES
+
+#define BRV_LINKER_SYSTEM               "system"
+#define BRV_LINKER_LLD                  "lld"
+#define BRV_LINKER_MOLD                 "mold"
+#define BRV_LINK_GDB_INDEX              "-Wl,--gdb-index"
+
+// LTO DEFINES
+
+#define BRV_LTO_OFF                     "off"
+#define BRV_LTO_FULL                    "full"
+#define BRV_LTO_THIN                    "thin"
+#define BRV_DIR_LTO_CACHE               "thinlto"
+
+// HASHING DEFINES
+
+#define BRV_HASH_OFFSET                 14695981039346656037ULL
+#define BRV_HASH_PRIME                  1099511628211ULL
+#define BRV_HASH_CHUNK_SIZE             65536
+
+// CACHE DEFINES
+
+#define BRV_ENV_CACHE_DIR               "BRAVO_CACHE_DIR"
+#define BRV_ENV_CACHE_SIZE              "BRAVO_CACHE_SIZE"
+#define BRV_CACHE_DEFAULT_SIZE          (5ULL << 30)
+#define BRV_CACHE_EVICT_RATIO           0.9
+#define BRV_CACHE_TMP_MARKER            ".tmp."
+#define BRV_CACHE_EXT_USED              ".used"
+#define BRV_CACHE_TMP_MAX_AGE           std::chrono::hours(1)
+#define BRV_CACHE_EVICT_STAMP           ".last_evict"
+#define BRV_CACHE_EVICT_INTERVAL        std::chrono::minutes(10)
+
+// PROCESS DEFINES
+
+#define BRV_PROC_POLL_MS                10
+#define BRV_PROC_BUFFER_SIZE            16384
+#define BRV_PROC_SPAWN_FAILURE          127
+#define BRV_PROC_SIGNAL_BASE            128
+#define BRV_PROC_LOAD_POLL_MS           250
+#define BRV_PROC_MEMORY_RATIO           0.8
+#define BRV_PROC_HEAVIEST_COUNT         5
+#define BRV_PROC_KILL_GRACE_MS          2000
+
+// SCHEDULING DEFINES
+
+#define BRV_SCHED_DEFAULT_COMPILE_MS    1000
+#define BRV_SCHED_DEFAULT_LINK_MS       500
+
+// UNITY DEFINES
+
+#define BRV_UNITY_DEFAULT_BATCH         8
+#define BRV_UNITY_GROUP_DIRECTORY       "directory"
+#define BRV_UNITY_GROUP_SIZE            "size"
+#define BRV_UNITY_STEM                  "unit_"
+
+// ANALYZE DEFINES
+
+#define BRV_ANALYZE_SUFFIX              "-analyze"
+#define BRV_ANALYZE_GRANULARITY_US      50
+#define BRV_ANALYZE_TOP_COUNT           10
+#define BRV_ANALYZE_EVENT_SOURCE        "Source"
+#define BRV_ANALYZE_EVENT_CLASS         "InstantiateClass"
+#define BRV_ANALYZE_EVENT_FUNCTION      "InstantiateFunction"
+
+// BENCH DEFINES
+
+#define BRV_FILE_NAME_BENCH             "bravo_bench.json"
+#define BRV_DIR_BENCH                   "bravo_bench"
+#define BRV_DIR_BENCH_TREE              "tree"
+#define BRV_BENCH_DEFAULT_FILES         2000
+#define BRV_BENCH_DEFAULT_PROJECTS      200
+#define BRV_BENCH_LAYERS                8
+#define BRV_BENCH_DEPTH                 4
+#define BRV_BENCH_FANOUT                4
+#define BRV_BENCH_RUNS                  5
+#define BRV_BENCH_APP                   "app"
+
+// PGO DEFINES
+
+#define BRV_PGO_SUFFIX_INSTRUMENTED     "-instrumented"
+#define BRV_PGO_SUFFIX_OPTIMIZED        "-pgo"
+#define BRV_PGO_DIR_RAW                 "profraw"
+#define BRV_PGO_PROFDATA                "llvm-profdata"
+
+// JOBSERVER DEFINES
+
+#define BRV_ENV_MAKEFLAGS               "MAKEFLAGS"
+#define BRV_JOBSERVER_AUTH              "--jobserver-auth"
+#define BRV_JOBSERVER_FDS               "--jobserver-fds"
+#define BRV_JOBSERVER_FIFO              "fifo:"
+#define BRV_JOBSERVER_TOKEN             '+'
+
+// WATCH DEFINES
+
+#define BRV_FILE_NAME_SOCKET            ".bravo_socket"
+#define BRV_WATCH_DEBOUNCE_MS           100
+#define BRV_WATCH_POLL_MS               500
+#define BRV_WATCH_BACKLOG               16
+#define BRV_WATCH_FALLBACK              -1
+
+// TRACE DEFINES
+
+#define BRV_TRACE_PID                   1
+#define BRV_TRACE_MAIN_TID              0
+
+// TEST DEFINES
+
+#define BRV_TEST_DEFAULT_TIMEOUT        300
+#define BRV_TEST_SLOWEST_COUNT          5
 
 // DEFAULT DEFINES
 
@@ -125,11 +364,40 @@ namespace brv {
     // TYPE ALIASES
 
     struct CmdContext;
+    struct Profile;
     typedef std::function<void(const CmdContext *)> BravoCmd;
-    typedef std::function<std::string(const std::vector<fs::path> &, std::vector<fs::path> &, const fs::path &)> LinkProcess;
+    typedef std::vector<std::string> Argv;
+    typedef std::function<Argv(const Profile &, const std::vector<fs::path> &, std::vector<fs::path> &, const fs::path &)> LinkProcess;
+    typedef std::unordered_map<fs::path, uint64_t> HashMemo;
+    struct FileStat;
+    typedef std::unordered_map<fs::path, FileStat> StatMemo;
 
     // STRUCTS
 
+    // Build profile as written in the config, unset values come from the profile it extends
+    struct ProfileConfig {
+        std::optional<std::string> inherits;
+        std::optional<std::string> opt;
+        std::optional<std::string> march;
+        std::optional<std::string> lto;
+        std::optional<std::string> linker;
+        std::optional<bool> debug;
+        std::optional<bool> gc_sections;
+        std::optional<bool> split_debug;
+        std::optional<bool> compress_debug;
+        std::vector<std::string> defines;
+        Argv flags;
+        Argv link_flags;
+    };
+    // Build profile flattened into compiler, linker and archiver commands
+    struct Profile {
+        std::string name;
+        Argv compile;
+        Argv link;
+        Argv archive;
+        std::vector<fs::path> link_inputs;
+        bool cacheable = true;
+    };
     // Config file tokens
     struct ConfigContext {
         fs::path root;
@@ -139,7 +407,92 @@ namespace brv {
         std::string build_name;
         std::optional<std::string> entry;
         std::optional<std::string> run_args;
+        std::optional<std::string> pch;
+        std::optional<std::string> pgo_train;
+        std::optional<std::string> linker;
+        std::optional<std::string> unity_group;
+        std::optional<unsigned int> jobs;
+        std::optional<unsigned int> memory;
+        std::optional<unsigned int> unity_batch;
+        std::vector<fs::path> unity_exclude;
         std::vector<fs::path> deps;
+        std::map<std::string, ProfileConfig> profiles;
+    };
+    // Result of a single stat call, timestamps in nanoseconds
+    struct FileStat {
+        bool exists = false;
+        bool dir = false;
+        int64_t mtime = 0;
+        uint64_t size = 0;
+    };
+    // Signatures of the last successful run of an action and the prerequisites of its depfile
+    struct ActionRecord {
+        uint64_t command = 0;
+        uint64_t content = 0;
+        uint64_t peak_rss = 0;
+        uint64_t cpu_ms = 0;
+        uint64_t duration_ms = 0;
+        int64_t depfile = 0;
+        std::vector<fs::path> prereqs;
+    };
+    // Listing of a directory as of its modification time
+    struct DirRecord {
+        int64_t mtime = 0;
+        bool seen = false;
+        std::vector<std::string> files;
+        std::vector<std::string> dirs;
+    };
+    // Content hash of an input as of its stat data
+    struct FileRecord {
+        int64_t mtime = 0;
+        uint64_t size = 0;
+        uint64_t hash = 0;
+    };
+    // Persistent action records, directory listings and input hashes of a project
+    struct BuildState {
+        fs::path path;
+        int64_t mtime = 0;
+        bool loaded = false;
+        bool dirty = false;
+        std::unordered_map<std::string, ActionRecord> records;
+        std::unordered_map<std::string, DirRecord> dirs;
+        std::unordered_map<std::string, FileRecord> files;
+    };
+    // On-disk state : header, dirs, files, records, string indices then a blob of null terminated strings
+    struct StateHeader {
+        uint32_t magic = BRV_STATE_MAGIC;
+        uint32_t version = BRV_STATE_VERSION;
+        uint32_t dirs = 0;
+        uint32_t files = 0;
+        uint32_t records = 0;
+        uint32_t indices = 0;
+        uint64_t bytes = 0;
+    };
+    struct StateDir {
+        uint32_t path;
+        uint32_t first;
+        uint32_t files;
+        uint32_t dirs;
+        int64_t mtime;
+    };
+    struct StateFile {
+        uint32_t path;
+        uint32_t reserved;
+        int64_t mtime;
+        uint64_t size;
+        uint64_t hash;
+    };
+    struct StateRecord {
+        uint32_t key;
+        uint32_t first;
+        uint32_t prereqs;
+        uint32_t reserved;
+        uint64_t command;
+        uint64_t content;
+        uint64_t peak_rss;
+        uint64_t cpu_ms;
+        uint64_t duration_ms;
+        int64_t depfile;
     };
     // Build data
     struct BuildContext {
@@ -148,19 +501,170 @@ namespace brv {
         fs::path obj_dir;
         fs::path src_dir;
         fs::path test_dir;
+        fs::path test_obj_dir;
+        fs::path test_bin_dir;
         fs::path include_dir;
+        fs::path module_dir;
+        fs::path pch_src;
+        fs::path pch_dst;
         std::vector<fs::path> src_files;
         std::vector<fs::path> obj_files;
         std::vector<fs::path> test_src_files;
         std::vector<fs::path> test_obj_files;
         std::vector<fs::path> test_exe_files;
         std::vector<fs::path> include_dirs;
+        BuildState *state = nullptr;
     };
     // Project config and build context
     struct ProjectContext {
         ConfigContext *config;
         BuildContext *build;
     };
+    // Compilation unit queued for the workers
+    struct CompileJob {
+        fs::path src;
+        fs::path obj;
+        Argv cmd;
+        Argv pre;
+        Argv flags;
+        BuildState *state;
+        fs::path root;
+        uint64_t key = 0;
+        uint64_t memory = 0;
+        uint64_t cost = 0;
+    };
+    // Shared object cache location and counters
+    struct CacheContext {
+        fs::path dir;
+        uintmax_t max_size;
+        uint64_t compiler;
+        std::atomic<unsigned int> hits = 0;
+        std::atomic<unsigned int> misses = 0;
+    };
+    // Span of the trace timeline, workers are assigned their track when written
+    struct TraceEvent {
+        std::string name;
+        std::string category;
+        uint64_t start = 0;
+        uint64_t end = 0;
+        bool worker = false;
+    };
+    // Chrome trace-event recording of a whole run
+    struct Trace {
+        fs::path path;
+        std::chrono::steady_clock::time_point origin;
+        std::vector<TraceEvent> events;
+    };
+    // Accumulated cost of a header or template across translation units
+    struct CostEntry {
+        uint64_t total_us = 0;
+        unsigned int count = 0;
+    };
+    // Compile time breakdown of every traced translation unit
+    struct AnalyzeReport {
+        unsigned int units = 0;
+        unsigned int missing = 0;
+        std::unordered_map<std::string, CostEntry> headers;
+        std::unordered_map<std::string, CostEntry> instantiations;
+    };
+    // Synthetic tree layout and the timings of every measured phase
+    struct BenchContext {
+        fs::path root;
+        unsigned int files = BRV_BENCH_DEFAULT_FILES;
+        unsigned int projects = BRV_BENCH_DEFAULT_PROJECTS;
+        unsigned int jobs = 0;
+        double load = 0;
+        std::vector<std::pair<std::string, std::vector<double>>> phases;
+    };
+    // Cursor over a project graph snapshot, invalid past the end
+    struct SnapshotReader {
+        const std::string *data;
+        size_t pos = 0;
+        bool valid = true;
+    };
+    // Child process and its captured output
+    struct Process {
+        Argv argv;
+        std::string name;
+        std::string category;
+        bool capture = true;
+        uint64_t timeout = 0;
+        bool timed_out = false;
+        uint64_t memory = 0;
+        uint64_t peak_rss = 0;
+        uint64_t cpu_ms = 0;
+        double priority = 0;
+        pid_t pid = -1;
+        int pidfd = -1;
+        int out = -1;
+        int status = -1;
+        std::string output;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+        std::function<void(Process *)> on_exit;
+    };
+    // GNU make jobserver token pool, shared with the parent and child processes
+    struct Jobserver {
+        int read = -1;
+        int write = -1;
+        bool owner = false;
+        bool nonblocking = false;
+    };
+    // Bounded pool of processes driven by a single event loop
+    struct Executor {
+        unsigned int jobs = 1;
+        double load = 0;
+        uint64_t memory_budget = 0;
+        uint64_t memory_used = 0;
+        bool failed = false;
+        bool throttled = false;
+        Jobserver *jobserver = nullptr;
+        Trace *trace = nullptr;
+        std::string tokens;
+        std::deque<Process *> queue;
+        std::vector<Process *> running;
+    };
+    // Node of the build graph, started once all of its dependencies completed
+    struct Action {
+        std::string name;
+        std::function<void(Action *)> start;
+        std::vector<Action *> dependents;
+        unsigned int pending = 0;
+        bool done = false;
+        double cost = 0;
+        double priority = -1;
+        double elapsed = 0;
+        std::chrono::steady_clock::time_point started;
+    };
+    // Every action of a build and the state they share
+    struct BuildGraph {
+        Executor exec;
+        std::deque<Action> actions;
+        std::deque<CompileJob> jobs;
+        std::unordered_map<const ProjectContext *, std::vector<Action *>> objects;
+        std::unordered_map<fs::path, Action *> tests;
+        std::unordered_map<const ProjectContext *, Action *> pch;
+        std::unordered_map<fs::path, std::string> provides;
+        std::unordered_map<fs::path, std::vector<std::string>> imports;
+        std::unordered_map<std::string, Action *> modules;
+        bool modular = false;
+        CacheContext *cache = nullptr;
+        HashMemo memo;
+        StatMemo stats;
+        const std::set<fs::path> *changed = nullptr;
+        std::vector<fs::path> watched;
+        Profile profile;
+        unsigned int compiled = 0;
+    };
+    // Outcome of a single test executable
+    struct TestResult {
+        fs::path exe;
+        bool done = false;
+        bool timed_out = false;
+        int status = -1;
+        double seconds = 0;
+        std::string output;
+    };
     // Cmd struct for function pointer and command constants
     struct Cmd {
         BravoCmd call;
@@ -175,22 +679,51 @@ namespace brv {
     // Cli data and global context
     struct CmdContext {
         Cmd cmd;
+        std::string cmd_name;
+        Argv argv;
+        Trace *trace = nullptr;
         bool verbose = false;
         bool rebuild = false;
         bool no_build = false;
+        bool unity = false;
+        bool time_trace = false;
+        std::string profile = BRV_PROFILE_DEFAULT;
+        fs::path pgo_generate;
+        fs::path pgo_use;
+        const std::set<fs::path> *changed = nullptr;
+        unsigned int jobs = 0;
+        unsigned int shard_index = 1;
+        unsigned int shard_count = 1;
+        unsigned int timeout = BRV_TEST_DEFAULT_TIMEOUT;
+        double load = 0;
         std::vector<std::string> non_opt_args;
         std::unordered_map<fs::path, std::vector<fs::path>> dep_graph;
         std::vector<ProjectContext *> projects;
+        std::unordered_map<fs::path, ProjectContext *> project_index;
         std::vector<ProjectContext *> build_protocol;
         ProjectContext *active_project;
     };
+    // Watch daemon descriptors and the changes it has not built yet
+    struct WatchContext {
+        int listen = -1;
+        int notify = -1;
+        fs::path socket;
+        std::set<fs::path> roots;
+        std::unordered_map<int, fs::path> dirs;
+        std::unordered_map<fs::path, fs::file_time_type> files;
+        std::set<fs::path> changed;
+        bool dirty = false;
+        bool moved = false;
+        bool reload = false;
+        bool built = false;
+    };
 
     // MAIN INTERFACE
 
     // Process cli arguments
     CmdContext *processCliArgs(int argc, char **argv);
     // Parse project config file
-    ConfigContext *processConfigFile(const CmdContext *cctx, const fs::path &root);
+    ConfigContext *processConfigFile(const CmdContext *cctx, const fs::path &root, jltt::JValue *json = nullptr);
     // Recursively parse dependecies
     BuildContext *processDeps(const ConfigContext *cfg, CmdContext *cctx);
     // Resolve dependecy graph and build protocol
@@ -215,54 +748,262 @@ namespace brv {
         void init(const CmdContext *cctx);
         // Compiles, links and runs test executables
         void test(const CmdContext *cctx);
+        // Keeps the project loaded and rebuilds it on file changes
+        void watch(const CmdContext *cctx);
+        // Builds with time traces and reports the most expensive headers and templates
+        void analyze(const CmdContext *cctx);
+        // Generates a synthetic project tree and times each phase on it
+        void bench(const CmdContext *cctx);
+        // Builds instrumented, trains and rebuilds every project with the merged profile
+        void pgo(const CmdContext *cctx);
     } // namespace cmd
 
     // INTERNAL FUNCTIONS
 
     namespace cli {
         std::string fuzzyMatch(const std::string &input, const std::vector<std::string> &valid);
-        void parseArg(const std::string &input, const std::string &cmd, CmdContext *cctx);
-        void setOpt(CmdContext *cctx, const std::string &cmd, unsigned int opt_id);
+        void parseArg(const std::vector<std::string> &args, size_t &index, const std::string &cmd, CmdContext *cctx);
+        std::string nextValue(const std::vector<std::string> &args, size_t &index);
+        void setOpt(CmdContext *cctx, const std::string &cmd, unsigned int opt_id, const std::optional<std::string> &value);
+        unsigned int parseUint(const std::string &value, const std::string &opt);
+        double parseDouble(const std::string &value, const std::string &opt);
     } // namespace cli
 
     namespace graph {
-        void build(std::set<fs::path> &visited, std::set<fs::path> &visiting, CmdContext *cctx, ProjectContext *pctx);
+        void build(std::unordered_set<const ProjectContext *> &visited, std::unordered_set<const ProjectContext *> &visiting, CmdContext *cctx, ProjectContext *pctx);
     } // namespace graph
 
     namespace config {
-        void load(ConfigContext *cfg);
+        void load(ConfigContext *cfg, jltt::JValue *json);
         jltt::JValue *read(const fs::path &root);
+        jltt::JValue *parse(const fs::path &root, std::string &error);
         std::string getString(jltt::JValue *json, const jltt::JString &key);
         std::optional<std::string> getOptString(jltt::JValue *json, const jltt::JString &key);
+        std::optional<double> getOptNumber(jltt::JValue *json, const jltt::JString &key);
+        std::optional<bool> getOptBool(jltt::JValue *json, const jltt::JString &key);
         std::vector<fs::path> getPathVec(jltt::JValue *json, const jltt::JString &key);
+        std::vector<std::string> getStringVec(jltt::JValue *json, const jltt::JString &key);
+        std::map<std::string, ProfileConfig> getProfiles(jltt::JValue *json, const jltt::JString &key);
         void validate(const ConfigContext *cfg, const CmdContext *cctx);
         void validateProjectName(const ConfigContext *cfg);
         void validateProjectType(const ConfigContext *cfg);
         void validateEntry(const ConfigContext *cfg);
         void validateDeps(const ConfigContext *cfg);
+        void validateJobs(const ConfigContext *cfg);
+        void validateMemory(const ConfigContext *cfg);
+        void validatePch(const ConfigContext *cfg);
+        void validateUnity(const ConfigContext *cfg);
+        void validateProfiles(const ConfigContext *cfg);
+        void validateProfileName(const std::string &name);
+        void validateLinker(const ConfigContext *cfg);
     } // namespace config
 
     namespace deps {
-        void scanProject(BuildContext *bctx, const ConfigContext *cfg);
+        void scanProject(BuildContext *bctx, const ConfigContext *cfg, const std::string &profile);
+        std::string scanTree(BuildContext *bctx, const ConfigContext *cfg, const std::string &profile);
         void scanDeps(const ConfigContext *cfg, CmdContext *cctx);
+        void loadLevel(const CmdContext *cctx, const std::vector<ProjectContext *> &level, const std::vector<fs::path> &roots);
+        void parallel(const std::vector<fs::path> &roots, const std::function<std::string(size_t)> &task);
     } // namespace deps
 
     namespace build {
-        void compile(const CmdContext *cctx);
-        void link(const CmdContext *cctx);
-        void worker(unsigned int id, bool verbose, const std::vector<std::string> &cmds, std::atomic<size_t> &index);
-        std::string linkExec(const std::vector<fs::path> &objs, std::vector<fs::path> &archs, const fs::path &dst);
-        std::string linkStatic(const std::vector<fs::path> &objs, std::vector<fs::path> &archs, const fs::path &dst);
-        std::string makeCompileCommand(const std::string &common, const fs::path &src, const fs::path &dst);
-        bool rebuild(const fs::path &src, const fs::path &obj);
-        int threadCount(const std::vector<std::string> &cmds);
+        void unify(const CmdContext *cctx);
+        bool writeUnity(const fs::path &dst, const std::vector<fs::path> &srcs);
+        std::vector<std::vector<fs::path>> balance(const std::vector<fs::path> &srcs, size_t batch);
+        void compile(const CmdContext *cctx, BuildGraph *graph);
+        Profile profile(const CmdContext *cctx);
+        void lto(const CmdContext *cctx, const ProfileConfig &config, Profile &profile);
+        void linker(const CmdContext *cctx, const ProfileConfig &config, Profile &profile);
+        ProfileConfig resolveProfile(const ConfigContext *cfg, const std::string &name, std::set<std::string> &visited);
+        Argv commonFlags(const CmdContext *cctx, const BuildGraph *graph, const ProjectContext *pctx, const Argv &base);
+        void scan(const CmdContext *cctx, BuildGraph *graph, const Argv &base);
+        void readScan(BuildGraph *graph, const fs::path &path, const std::unordered_map<fs::path, fs::path> &sources);
+        std::vector<size_t> order(const BuildGraph *graph, const std::vector<fs::path> &srcs);
+        bool importsRebuilt(const BuildGraph *graph, const fs::path &src);
+        void bindModules(BuildGraph *graph, Action *action, const fs::path &src);
+        fs::path bmi(const BuildContext *bctx, const std::string &name);
+        void link(const CmdContext *cctx, BuildGraph *graph);
+        void execute(const CmdContext *cctx, BuildGraph *graph);
+        Action *plan(const CmdContext *cctx, BuildGraph *graph, CompileJob *job);
+        Action *precompile(const CmdContext *cctx, BuildGraph *graph, const ProjectContext *pctx, const Argv &common, const Argv &base);
+        void usePch(const BuildContext *bctx, Argv &common, Argv &pre);
+        Action *plan(const CmdContext *cctx, BuildGraph *graph, const Argv &cmd, const std::string &name, const std::vector<fs::path> &inputs, const fs::path &dst, BuildState *state);
+        bool linked(BuildGraph *graph, const Argv &cmd, const std::vector<fs::path> &inputs, const fs::path &dst, BuildState *state);
+        Argv linkExec(const Profile &profile, const std::vector<fs::path> &objs, std::vector<fs::path> &archs, const fs::path &dst);
+        Argv linkStatic(const Profile &profile, const std::vector<fs::path> &objs, std::vector<fs::path> &archs, const fs::path &dst);
+        Argv makeCompileCommand(const Argv &common, const fs::path &src, const fs::path &dst);
+        Argv makePreprocessCommand(const Argv &common, const fs::path &src, const fs::path &dst);
+        Argv makePrecompileCommand(const Argv &common, const fs::path &src, const fs::path &dst);
+        bool rebuild(BuildGraph *graph, const fs::path &src, const fs::path &obj, const Argv &cmd, BuildState *state);
+        uint64_t digest(const std::vector<fs::path> &files, BuildState *state, HashMemo &memo);
+        void sign(BuildGraph *graph, const CompileJob *job, const Process *proc);
+        uint64_t predict(BuildState *state, const fs::path &obj, uint64_t average);
+        uint64_t estimate(BuildState *state, const fs::path &dst, uint64_t fallback);
+        void report(const BuildGraph *graph);
+        uint64_t memoryBudget(const CmdContext *cctx);
+        std::vector<fs::path> readDepfile(const fs::path &dep);
+        bool selected(const CmdContext *cctx, const fs::path &test);
+        unsigned int threadCount(const CmdContext *cctx);
     } // namespace build
 
+    namespace proc {
+        void configure(const CmdContext *cctx, Executor *exec);
+        void submit(Executor *exec, Process *proc, bool urgent = false);
+        void loop(Executor *exec);
+        std::deque<Process *>::iterator pick(Executor *exec);
+        bool admit(Executor *exec);
+        void spawn(Process *proc);
+        void drain(Process *proc);
+        void reap(Process *proc);
+        void expire(Process *proc);
+        void interrupt(int signal);
+        void terminate(Executor *exec);
+        int deadline(const Executor *exec, int wait);
+        int run(const Argv &argv);
+        int capture(const Argv &argv, std::string &output);
+        Argv split(const std::string &str);
+        std::string join(const Argv &argv);
+        fs::path which(const std::string &name);
+    } // namespace proc
+
+    namespace jobserver {
+        Jobserver *connect(unsigned int jobs, bool verbose);
+        void reopen(Jobserver *server);
+        bool acquire(Executor *exec);
+        void release(Executor *exec);
+        void flush();
+    } // namespace jobserver
+
+    namespace sched {
+        Action *add(BuildGraph *graph, const std::string &name, const std::function<void(Action *)> &start);
+        void depend(Action *action, Action *dep);
+        void start(BuildGraph *graph, Action *action);
+        void complete(BuildGraph *graph, Action *action);
+        double priority(Action *action);
+        double criticalPath(const BuildGraph *graph, bool actual);
+        void run(BuildGraph *graph);
+    } // namespace sched
+
+    namespace state {
+        void load(BuildState *state);
+        void save(BuildState *state);
+        void reload(BuildState *state);
+        ActionRecord *find(BuildState *state, const fs::path &key);
+        void record(BuildState *state, const fs::path &key, const ActionRecord &record);
+        uint64_t averageRss(const BuildState *state);
+        uint64_t averageDuration(const BuildState *state);
+        void recurse(BuildState *state, const fs::path &dir, std::vector<fs::path> &files, const std::set<std::string> &exts);
+        const std::vector<fs::path> *prereqs(BuildState *state, ActionRecord *record, const fs::path &obj);
+        uint64_t hash(BuildState *state, const fs::path &path, HashMemo &memo);
+        uint32_t intern(std::string &blob, std::unordered_map<std::string, uint32_t> &offsets, const std::string &str);
+    } // namespace state
+
+    namespace cache {
+        CacheContext *open(const std::string &compiler);
+        uint64_t key(const CacheContext *cache, const CompileJob &job);
+        bool fetch(CacheContext *cache, uint64_t key, const fs::path &obj);
+        void store(CacheContext *cache, uint64_t key, const fs::path &obj);
+        void restore(const fs::path &entry, const fs::path &obj);
+        void evict(const CacheContext *cache);
+        fs::path entry(const CacheContext *cache, uint64_t key);
+        uintmax_t parseSize(const std::string &str);
+    } // namespace cache
+
+    namespace hash {
+        uint64_t bytes(const char *data, size_t size, uint64_t seed = BRV_HASH_OFFSET);
+        uint64_t string(const std::string &str, uint64_t seed = BRV_HASH_OFFSET);
+        uint64_t argv(const Argv &argv, uint64_t seed = BRV_HASH_OFFSET);
+        uint64_t file(const fs::path &path, uint64_t seed = BRV_HASH_OFFSET);
+        uint64_t combine(uint64_t seed, uint64_t value);
+        uint64_t memoFile(const fs::path &path, HashMemo &memo);
+    } // namespace hash
+
+    namespace tests {
+        void report(const CmdContext *cctx, const TestResult &result);
+        void summary(const std::vector<TestResult> &results, double seconds);
+        std::string seconds(double seconds);
+    } // namespace tests
+
+    namespace analyze {
+        std::vector<fs::path> collect(const CmdContext *cctx);
+        void read(AnalyzeReport *report, const fs::path &path);
+        void add(std::unordered_map<std::string, CostEntry> &costs, const std::string &key, uint64_t duration);
+        void print(const std::string &title, const std::unordered_map<std::string, CostEntry> &costs);
+    } // namespace analyze
+
+    namespace pgo {
+        void stage(const CmdContext *cctx, const std::string &variant);
+        void train(const CmdContext *cctx, const fs::path &raw);
+        fs::path merge(const fs::path &raw, const fs::path &dir);
+    } // namespace pgo
+
+    namespace bench {
+        void claim(const fs::path &dir);
+        void cleanup();
+        void generate(const BenchContext *bench);
+        void project(const fs::path &root, const std::string &name, const std::vector<std::string> &deps, unsigned int files, bool exec);
+        std::string name(unsigned int index);
+        CmdContext *load(BenchContext *bench);
+        void measure(BenchContext *bench, const std::string &phase, const std::function<void()> &call);
+        void write(const BenchContext *bench, const fs::path &path);
+    } // namespace bench
+
+    namespace snapshot {
+        bool load(CmdContext *cctx, const fs::path &root);
+        void save(const CmdContext *cctx);
+        fs::path path(const fs::path &root);
+        void putNumber(std::string &out, uint64_t value);
+        void putString(std::string &out, const std::string &str);
+        void putPaths(std::string &out, const std::vector<fs::path> &paths);
+        void putStrings(std::string &out, const std::vector<std::string> &strs);
+        void putProfiles(std::string &out, const std::map<std::string, ProfileConfig> &profiles);
+        uint64_t getNumber(SnapshotReader *reader);
+        std::string getString(SnapshotReader *reader);
+        std::vector<fs::path> getPaths(SnapshotReader *reader);
+        std::vector<std::string> getStrings(SnapshotReader *reader);
+        std::map<std::string, ProfileConfig> getProfiles(SnapshotReader *reader);
+    } // namespace snapshot
+
+    namespace trace {
+        Trace *open(const fs::path &path);
+        uint64_t now(const Trace *trace);
+        uint64_t micros(const Trace *trace, std::chrono::steady_clock::time_point time);
+        void phase(Trace *trace, const std::string &name, uint64_t start);
+        void process(Trace *trace, const Process *proc);
+        void write(const Trace *trace);
+        void flush();
+    } // namespace trace
+
+    namespace watch {
+        bool forward(const CmdContext *cctx);
+        int dial(const fs::path &path);
+        void open(const CmdContext *cctx, WatchContext *wctx);
+        void close(WatchContext *wctx);
+        void add(WatchContext *wctx, const fs::path &dir, bool recursive);
+        std::vector<fs::path> inputs(const ProjectContext *pctx);
+        bool covers(const std::vector<fs::path> &dirs, const fs::path &path);
+        bool changed(WatchContext *wctx);
+        std::unordered_map<fs::path, fs::file_time_type> snapshot(const WatchContext *wctx);
+        bool stale(const CmdContext *cctx);
+        bool intact(const CmdContext *cctx);
+        void serve(const CmdContext *cctx, WatchContext *wctx);
+        int build(const CmdContext *cctx, WatchContext *wctx, int out);
+        void invalidate(const CmdContext *cctx, const std::set<fs::path> &changed);
+        void refresh(const CmdContext *cctx);
+        void restart(const CmdContext *cctx, WatchContext *wctx);
+        fs::path socket(const fs::path &root, const std::string &profile);
+    } // namespace watch
+
     namespace file {
         bool isdir(const fs::path &dir);
         bool isfile(const fs::path &file);
+        FileStat stat(const fs::path &path);
+        const FileStat &stat(const fs::path &path, StatMemo &memo);
+        void touch(const fs::path &path);
         void recurse(const fs::path &dir, std::vector<fs::path> &files, const std::string &target_ext);
         void swap(const std::vector<fs::path> &srcs, std::vector<fs::path> &dsts, const fs::path &src, const fs::path &dst, const std::string &ext);
+        bool update(const fs::path &path, const std::string &content);
+        std::string quote(const std::string &str);
     } // namespace file
 
     // CLI CONSTANTS
@@ -274,6 +1015,10 @@ namespace brv {
         BRV_CMD_CLEAN_STR,
         BRV_CMD_INIT_STR,
         BRV_CMD_TEST_STR,
+        BRV_CMD_WATCH_STR,
+        BRV_CMD_ANALYZE_STR,
+        BRV_CMD_BENCH_STR,
+        BRV_CMD_PGO_STR,
     };
     inline const std::unordered_map<std::string, std::string> CMD_USAGE_MAP = {
         {BRV_CMD_HELP_STR, BRV_CMD_HELP_USAGE},
@@ -282,6 +1027,10 @@ namespace brv {
         {BRV_CMD_CLEAN_STR, BRV_CMD_CLEAN_USAGE},
         {BRV_CMD_INIT_STR, BRV_CMD_INIT_USAGE},
         {BRV_CMD_TEST_STR, BRV_CMD_TEST_USAGE},
+        {BRV_CMD_WATCH_STR, BRV_CMD_WATCH_USAGE},
+        {BRV_CMD_ANALYZE_STR, BRV_CMD_ANALYZE_USAGE},
+        {BRV_CMD_BENCH_STR, BRV_CMD_BENCH_USAGE},
+        {BRV_CMD_PGO_STR, BRV_CMD_PGO_USAGE},
     };
     inline const std::unordered_map<std::string, Cmd> CMD_MAP = {
         {BRV_CMD_HELP_STR, {
@@ -314,34 +1063,94 @@ namespace brv {
             BRV_CMD_TEST_SKIP_CONFIG,
             BRV_CMD_TEST_NON_OPT_ARGC_MAX,
         }},
+        {BRV_CMD_WATCH_STR, {
+            cmd::watch,
+            BRV_CMD_WATCH_SKIP_CONFIG,
+            BRV_CMD_WATCH_NON_OPT_ARGC_MAX,
+        }},
+        {BRV_CMD_ANALYZE_STR, {
+            cmd::analyze,
+            BRV_CMD_ANALYZE_SKIP_CONFIG,
+            BRV_CMD_ANALYZE_NON_OPT_ARGC_MAX,
+        }},
+        {BRV_CMD_BENCH_STR, {
+            cmd::bench,
+            BRV_CMD_BENCH_SKIP_CONFIG,
+            BRV_CMD_BENCH_NON_OPT_ARGC_MAX,
+        }},
+        {BRV_CMD_PGO_STR, {
+            cmd::pgo,
+            BRV_CMD_PGO_SKIP_CONFIG,
+            BRV_CMD_PGO_NON_OPT_ARGC_MAX,
+        }},
     };
     inline const std::unordered_map<std::string, std::set<unsigned int>> VALID_OPT_IDS = {
         {BRV_CMD_HELP_STR, {BRV_OPT_VERBOSE_ID}},
-        {BRV_CMD_BUILD_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_DEPS_ID}},
-        {BRV_CMD_RUN_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_DEPS_ID, BRV_OPT_NO_BUILD_ID}},
+        {BRV_CMD_BUILD_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_DEPS_ID, BRV_OPT_JOBS_ID, BRV_OPT_LOAD_ID, BRV_OPT_UNITY_ID, BRV_OPT_TRACE_ID, BRV_OPT_PROFILE_ID}},
+        {BRV_CMD_RUN_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_DEPS_ID, BRV_OPT_NO_BUILD_ID, BRV_OPT_JOBS_ID, BRV_OPT_LOAD_ID, BRV_OPT_UNITY_ID, BRV_OPT_TRACE_ID, BRV_OPT_PROFILE_ID}},
         {BRV_CMD_CLEAN_STR, {BRV_OPT_VERBOSE_ID}},
         {BRV_CMD_INIT_STR, {BRV_OPT_VERBOSE_ID}},
-        {BRV_CMD_TEST_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_DEPS_ID, BRV_OPT_NO_BUILD_ID}},
+        {BRV_CMD_TEST_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_DEPS_ID, BRV_OPT_NO_BUILD_ID, BRV_OPT_JOBS_ID, BRV_OPT_SHARD_ID, BRV_OPT_TIMEOUT_ID, BRV_OPT_LOAD_ID, BRV_OPT_UNITY_ID, BRV_OPT_TRACE_ID, BRV_OPT_PROFILE_ID}},
+        {BRV_CMD_WATCH_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_JOBS_ID, BRV_OPT_LOAD_ID, BRV_OPT_UNITY_ID, BRV_OPT_PROFILE_ID}},
+        {BRV_CMD_ANALYZE_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_JOBS_ID, BRV_OPT_LOAD_ID, BRV_OPT_UNITY_ID, BRV_OPT_TRACE_ID, BRV_OPT_PROFILE_ID}},
+        {BRV_CMD_BENCH_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_JOBS_ID, BRV_OPT_LOAD_ID}},
+        {BRV_CMD_PGO_STR, {BRV_OPT_VERBOSE_ID, BRV_OPT_JOBS_ID, BRV_OPT_LOAD_ID, BRV_OPT_UNITY_ID, BRV_OPT_TRACE_ID, BRV_OPT_PROFILE_ID}},
+    };
+    inline const std::set<unsigned int> VALUED_OPT_IDS = {
+        BRV_OPT_JOBS_ID,
+        BRV_OPT_SHARD_ID,
+        BRV_OPT_TIMEOUT_ID,
+        BRV_OPT_LOAD_ID,
+        BRV_OPT_TRACE_ID,
+        BRV_OPT_PROFILE_ID,
     };
     inline const std::vector<std::string> OPT_LONG_VECTOR {
         BRV_OPT_VERBOSE_STR_LONG,
         BRV_OPT_DEPS_STR_LONG,
         BRV_OPT_NO_BUILD_STR_LONG,
+        BRV_OPT_JOBS_STR_LONG,
+        BRV_OPT_SHARD_STR_LONG,
+        BRV_OPT_TIMEOUT_STR_LONG,
+        BRV_OPT_LOAD_STR_LONG,
+        BRV_OPT_UNITY_STR_LONG,
+        BRV_OPT_TRACE_STR_LONG,
+        BRV_OPT_PROFILE_STR_LONG,
     };
     inline const std::set<char> OPT_SHORT_SET {
         BRV_OPT_VERBOSE_STR_SHRT,
         BRV_OPT_DEPS_STR_SHRT,
         BRV_OPT_NO_BUILD_STR_SHRT,
+        BRV_OPT_JOBS_STR_SHRT,
+        BRV_OPT_SHARD_STR_SHRT,
+        BRV_OPT_TIMEOUT_STR_SHRT,
+        BRV_OPT_LOAD_STR_SHRT,
+        BRV_OPT_UNITY_STR_SHRT,
+        BRV_OPT_TRACE_STR_SHRT,
+        BRV_OPT_PROFILE_STR_SHRT,
     };
     inline const std::unordered_map<std::string, unsigned int> OPT_LONG_MAP {
         {BRV_OPT_VERBOSE_STR_LONG, BRV_OPT_VERBOSE_ID},
         {BRV_OPT_DEPS_STR_LONG, BRV_OPT_DEPS_ID},
         {BRV_OPT_NO_BUILD_STR_LONG, BRV_OPT_NO_BUILD_ID},
+        {BRV_OPT_JOBS_STR_LONG, BRV_OPT_JOBS_ID},
+        {BRV_OPT_SHARD_STR_LONG, BRV_OPT_SHARD_ID},
+        {BRV_OPT_TIMEOUT_STR_LONG, BRV_OPT_TIMEOUT_ID},
+        {BRV_OPT_LOAD_STR_LONG, BRV_OPT_LOAD_ID},
+        {BRV_OPT_UNITY_STR_LONG, BRV_OPT_UNITY_ID},
+        {BRV_OPT_TRACE_STR_LONG, BRV_OPT_TRACE_ID},
+        {BRV_OPT_PROFILE_STR_LONG, BRV_OPT_PROFILE_ID},
     };
     inline const std::unordered_map<char, unsigned int> OPT_SHORT_MAP {
         {BRV_OPT_VERBOSE_STR_SHRT, BRV_OPT_VERBOSE_ID},
         {BRV_OPT_DEPS_STR_SHRT, BRV_OPT_DEPS_ID},
         {BRV_OPT_NO_BUILD_STR_SHRT, BRV_OPT_NO_BUILD_ID},
+        {BRV_OPT_JOBS_STR_SHRT, BRV_OPT_JOBS_ID},
+        {BRV_OPT_SHARD_STR_SHRT, BRV_OPT_SHARD_ID},
+        {BRV_OPT_TIMEOUT_STR_SHRT, BRV_OPT_TIMEOUT_ID},
+        {BRV_OPT_LOAD_STR_SHRT, BRV_OPT_LOAD_ID},
+        {BRV_OPT_UNITY_STR_SHRT, BRV_OPT_UNITY_ID},
+        {BRV_OPT_TRACE_STR_SHRT, BRV_OPT_TRACE_ID},
+        {BRV_OPT_PROFILE_STR_SHRT, BRV_OPT_PROFILE_ID},
     };
 
     inline const std::map<std::string, std::pair<char, std::string>> OPT_USAGE_MAP = {
@@ -357,6 +1166,34 @@ namespace brv {
             BRV_OPT_NO_BUILD_STR_SHRT,
             BRV_OPT_NO_BUILD_USAGE
         }},
+        {BRV_OPT_JOBS_STR_LONG, {
+            BRV_OPT_JOBS_STR_SHRT,
+            BRV_OPT_JOBS_USAGE
+        }},
+        {BRV_OPT_SHARD_STR_LONG, {
+            BRV_OPT_SHARD_STR_SHRT,
+            BRV_OPT_SHARD_USAGE
+        }},
+        {BRV_OPT_TIMEOUT_STR_LONG, {
+            BRV_OPT_TIMEOUT_STR_SHRT,
+            BRV_OPT_TIMEOUT_USAGE
+        }},
+        {BRV_OPT_LOAD_STR_LONG, {
+            BRV_OPT_LOAD_STR_SHRT,
+            BRV_OPT_LOAD_USAGE
+        }},
+        {BRV_OPT_UNITY_STR_LONG, {
+            BRV_OPT_UNITY_STR_SHRT,
+            BRV_OPT_UNITY_USAGE
+        }},
+        {BRV_OPT_TRACE_STR_LONG, {
+            BRV_OPT_TRACE_STR_SHRT,
+            BRV_OPT_TRACE_USAGE
+        }},
+        {BRV_OPT_PROFILE_STR_LONG, {
+            BRV_OPT_PROFILE_STR_SHRT,
+            BRV_OPT_PROFILE_USAGE
+        }},
     };
 
     // PARSING CONSTANTS
@@ -365,15 +1202,42 @@ namespace brv {
         BRV_PROJECT_TYPE_EXEC,
         BRV_PROJECT_TYPE_STATIC,
     };
+    inline const std::set<std::string> VALID_PROFILE_OPTS = {
+        "0", "1", "2", "3", "s", "z", "g", "fast",
+    };
+    inline const std::set<std::string> VALID_LINKERS = {
+        BRV_LINKER_SYSTEM,
+        BRV_LINKER_LLD,
+        BRV_LINKER_MOLD,
+    };
+    inline const std::set<std::string> VALID_LTO_MODES = {
+        BRV_LTO_OFF,
+        BRV_LTO_FULL,
+        BRV_LTO_THIN,
+    };
+    // Linkers that understand the thin LTO cache flags of the platform
+    inline const std::set<std::string> VALID_LTO_THIN_LINKERS = BRV_LTO_THIN_LINKERS;
     inline const std::vector<Validation> VALIDATION_MAP = {
         {config::validateProjectName, BRV_VALIDATION_PROJECT_NAME},
         {config::validateProjectType, BRV_VALIDATION_PROJECT_TYPE},
         {config::validateEntry, BRV_VALIDATION_ENTRY},
         {config::validateDeps, BRV_VALIDATION_DEPS},
+        {config::validateJobs, BRV_VALIDATION_JOBS},
+        {config::validateMemory, BRV_VALIDATION_MEMORY},
+        {config::validatePch, BRV_VALIDATION_PCH},
+        {config::validateUnity, BRV_VALIDATION_UNITY},
+        {config::validateProfiles, BRV_VALIDATION_PROFILES},
+        {config::validateLinker, BRV_VALIDATION_LINKER},
     };
 
     // BUILDING CONSTANTS
 
+    inline const std::map<std::string, ProfileConfig> PROFILE_MAP = {
+        {BRV_PROFILE_DEBUG, {{}, "0", {}, {}, {}, true, false, {}, {}, {}, {}, {}}},
+        {BRV_PROFILE_RELEASE, {{}, "2", {}, {}, {}, false, true, {}, {}, {"NDEBUG"}, {}, {}}},
+        {BRV_PROFILE_RELWITHDEBINFO, {{}, "2", {}, {}, {}, true, false, {}, {}, {"NDEBUG"}, {}, {}}},
+    };
+
     inline const std::unordered_map<std::string, LinkProcess> LINK_PROCESS_MAP = {
         {BRV_PROJECT_TYPE_EXEC, build::linkExec},
         {BRV_PROJECT_TYPE_STATIC, build::linkStatic},
@@ -0,0 +1,85 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace brv;
+
+std::vector<fs::path> analyze::collect(const CmdContext *cctx) {
+    std::vector<fs::path> traces{};
+    for (const ProjectContext *pctx : cctx->build_protocol) {
+        for (const fs::path &obj : pctx->build->obj_files)
+            traces.push_back(fs::path(obj).replace_extension(BRV_FILE_EXT_TIME_TRACE));
+        for (const fs::path &obj : pctx->build->test_obj_files)
+            traces.push_back(fs::path(obj).replace_extension(BRV_FILE_EXT_TIME_TRACE));
+    }
+    return traces;
+}
+
+void analyze::read(AnalyzeReport *report, const fs::path &path) {
+    jltt::Parser *parser = new jltt::Parser(path);
+    if (parser->state() != jltt::STATE_OPEN) {
+        delete parser;
+        ++report->missing;
+        return;
+    }
+    parser->start();
+    BRV_ASSERT(parser->state() == jltt::STATE_SUCCESS, "Failed to parse time trace ", path, ".");
+
+    jltt::JValue *json = parser->root();
+    delete parser;
+
+    jltt::JValue *events = json->at("traceEvents");
+    BRV_ASSERT(events != nullptr && events->is<jltt::JArray>(), "Invalid time trace ", path, ".");
+    ++report->units;
+
+    // Complete events only, nested headers are counted inclusively like the compiler reports them
+    for (jltt::JValue *event : *events->as<jltt::JArray>()) {
+        jltt::JValue *name = event->at("name");
+        jltt::JValue *dur = event->at("dur");
+        jltt::JValue *args = event->at("args");
+        if (name == nullptr || !name->is<jltt::JString>() || dur == nullptr || !dur->is<jltt::JNumber>() || args == nullptr) continue;
+
+        jltt::JValue *detail = args->at("detail");
+        if (detail == nullptr || !detail->is<jltt::JString>()) continue;
+
+        const std::string &kind = *name->as<jltt::JString>();
+        const uint64_t duration = *dur->as<jltt::JNumber>();
+        if (kind == BRV_ANALYZE_EVENT_SOURCE)
+            add(report->headers, fs::path(*detail->as<jltt::JString>()).lexically_normal().string(), duration);
+        else if (kind == BRV_ANALYZE_EVENT_CLASS || kind == BRV_ANALYZE_EVENT_FUNCTION)
+            add(report->instantiations, *detail->as<jltt::JString>(), duration);
+    }
+
+    delete json;
+}
+
+void analyze::add(std::unordered_map<std::string, CostEntry> &costs, const std::string &key, uint64_t duration) {
+    CostEntry &entry = costs[key];
+    entry.total_us += duration;
+    ++entry.count;
+}
+
+void analyze::print(const std::string &title, const std::unordered_map<std::string, CostEntry> &costs) {
+    std::vector<const std::pair<const std::string, CostEntry> *> ranked{};
+    for (const std::pair<const std::string, CostEntry> &pair : costs)
+        ranked.push_back(&pair);
+    if (ranked.empty()) return;
+
+    std::sort(ranked.begin(), ranked.end(), [](const auto *a, const auto *b) {
+        return a->second.total_us > b->second.total_us;
+    });
+    if (ranked.size() > BRV_ANALYZE_TOP_COUNT)
+        ranked.resize(BRV_ANALYZE_TOP_COUNT);
+
+    // Totals and averages in milliseconds, most instantiations are well below a second
+    std::ostringstream str;
+    str << title << ":" << std::fixed << std::setprecision(1) << std::left;
+    for (const std::pair<const std::string, CostEntry> *pair : ranked)
+        str << std::endl << "        " << std::setw(12) << pair->second.total_us / 1000.0
+            << std::setw(8) << std::to_string(pair->second.count) + "x"
+            << std::setw(12) << pair->second.total_us / 1000.0 / pair->second.count << pair->first;
+    BRV_INFO(str.str());
+}
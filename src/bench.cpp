@@ -0,0 +1,153 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace brv;
+
+// Removed on exit, a failed phase must not leave the generated tree behind
+static fs::path scratch{};
+
+void bench::claim(const fs::path &dir) {
+    scratch = dir;
+    std::atexit(cleanup);
+}
+
+void bench::cleanup() {
+    if (scratch.empty()) return;
+
+    std::error_code error;
+    fs::remove_all(scratch, error);
+    scratch.clear();
+}
+
+void bench::generate(const BenchContext *bench) {
+    const unsigned int layers = std::min(bench->projects, (unsigned int)BRV_BENCH_LAYERS);
+    const unsigned int width = (bench->projects + layers - 1) / layers;
+    const unsigned int files = std::max(1u, bench->files / (bench->projects + 1));
+
+    // Every project depends on two neighbours of the next layer, so each layer closes a row of diamonds
+    for (unsigned int i = 0; i < bench->projects; ++i) {
+        const unsigned int layer = i / width;
+        std::vector<std::string> deps{};
+        for (const unsigned int column : {i % width, (i + 1) % width}) {
+            const unsigned int dep = (layer + 1) * width + column;
+            if (dep < bench->projects && (deps.empty() || deps.front() != name(dep)))
+                deps.push_back(name(dep));
+        }
+        project(bench->root, name(i), deps, files, false);
+    }
+
+    std::vector<std::string> top{};
+    for (unsigned int i = 0; i < std::min(width, bench->projects); ++i)
+        top.push_back(name(i));
+    project(bench->root, BRV_BENCH_APP, top, files, true);
+}
+
+void bench::project(const fs::path &root, const std::string &name, const std::vector<std::string> &deps, unsigned int files, bool exec) {
+    const fs::path dir = root / name;
+    fs::create_directories(dir / BRV_DIR_SRC);
+
+    std::ostringstream json;
+    json << "{" << std::endl;
+    json << "  \"" << BRV_KEY_PROJECT_NAME << "\": \"" << name << "\"," << std::endl;
+    json << "  \"" << BRV_KEY_PROJECT_TYPE << "\": \"" << (exec ? BRV_PROJECT_TYPE_EXEC : BRV_PROJECT_TYPE_STATIC) << "\"," << std::endl;
+    if (exec) json << "  \"" << BRV_KEY_ENTRY << "\": \"" << BRV_DEFAULT_ENTRY << "\"," << std::endl;
+    json << "  \"" << BRV_KEY_DEPS << "\": [";
+    for (size_t i = 0; i < deps.size(); ++i)
+        json << (i == 0 ? "" : ", ") << file::quote((root / deps.at(i)).string());
+    json << "]," << std::endl;
+    json << "  \"" << BRV_KEY_BUILD_NAME << "\": \"" << name << "\"" << std::endl;
+    json << "}" << std::endl;
+    file::update(dir / BRV_FILE_NAME_CONFIG, json.str());
+
+    file::update(dir / BRV_DIR_INCLUDE / name / (name + ".hpp"), "#pragma once\n\nint " + name + "_f0();\n");
+
+    // Sources spread over a shallow tree of directories, each calling into its first dependency
+    for (unsigned int k = 0; k < files; ++k) {
+        fs::path path = dir / BRV_DIR_SRC;
+        for (unsigned int level = 0, index = k; level < k % (BRV_BENCH_DEPTH + 1); ++level, index /= BRV_BENCH_FANOUT)
+            path /= "d" + std::to_string(index % BRV_BENCH_FANOUT);
+
+        std::ostringstream src;
+        src << "#include <" << name << "/" << name << ".hpp>" << std::endl;
+        if (!deps.empty()) src << "#include <" << deps.front() << "/" << deps.front() << ".hpp>" << std::endl;
+        src << std::endl << "int " << name << "_f" << k << "() { return " << (deps.empty() ? "0" : deps.front() + "_f0()") << " + " << k << "; }" << std::endl;
+        file::update(path / ("f" + std::to_string(k) + BRV_FILE_EXT_CPP), src.str());
+    }
+    if (!exec) return;
+
+    std::ostringstream main;
+    for (const std::string &dep : deps)
+        main << "#include <" << dep << "/" << dep << ".hpp>" << std::endl;
+    main << std::endl << "int main() {" << std::endl << "    int sum = 0;" << std::endl;
+    for (const std::string &dep : deps)
+        main << "    sum += " << dep << "_f0();" << std::endl;
+    main << "    return sum < 0;" << std::endl << "}" << std::endl;
+    file::update(dir / BRV_DIR_SRC / BRV_DEFAULT_ENTRY, main.str());
+}
+
+std::string bench::name(unsigned int index) {
+    return "lib" + std::to_string(index);
+}
+
+CmdContext *bench::load(BenchContext *bench) {
+    CmdContext *cctx = new CmdContext();
+    cctx->cmd = CMD_MAP.at(BRV_CMD_BUILD_STR);
+    cctx->cmd_name = BRV_CMD_BUILD_STR;
+    cctx->jobs = bench->jobs;
+    cctx->load = bench->load;
+
+    ProjectContext *pctx = new ProjectContext();
+    cctx->projects.emplace_back(pctx);
+    cctx->active_project = pctx;
+
+    // Same sequence as the main entry point
+    measure(bench, "config", [&]() { pctx->config = processConfigFile(cctx, bench->root / BRV_BENCH_APP); });
+    measure(bench, "deps", [&]() { pctx->build = processDeps(pctx->config, cctx); });
+    measure(bench, "resolve", [&]() { resolveProtocol(cctx); });
+    return cctx;
+}
+
+void bench::measure(BenchContext *bench, const std::string &phase, const std::function<void()> &call) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    call();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (std::pair<std::string, std::vector<double>> &pair : bench->phases)
+        if (pair.first == phase) {
+            pair.second.push_back(ms);
+            return;
+        }
+    bench->phases.push_back({phase, {ms}});
+}
+
+void bench::write(const BenchContext *bench, const fs::path &path) {
+    std::ofstream file(path, std::ios::trunc);
+    BRV_ASSERT(file.is_open(), "Failed to write benchmark results ", path, ".");
+
+    file << std::fixed << std::setprecision(3);
+    file << "{" << std::endl;
+    file << "  \"version\": \"" << BRV_VERSION_MAJOR << "." << BRV_VERSION_MINOR << "." << BRV_VERSION_PATCH << "\"," << std::endl;
+    file << "  \"files\": " << bench->files << "," << std::endl;
+    file << "  \"projects\": " << bench->projects << "," << std::endl;
+    file << "  \"runs\": " << BRV_BENCH_RUNS << "," << std::endl;
+    file << "  \"phases\": {";
+
+    for (size_t i = 0; i < bench->phases.size(); ++i) {
+        std::vector<double> samples = bench->phases.at(i).second;
+        std::sort(samples.begin(), samples.end());
+
+        file << (i == 0 ? "" : ",") << std::endl << "    " << file::quote(bench->phases.at(i).first) << ": {"
+             << "\"min_ms\": " << samples.front() << ", \"median_ms\": " << samples.at(samples.size() / 2)
+             << ", \"max_ms\": " << samples.back() << ", \"samples_ms\": [";
+        for (size_t j = 0; j < bench->phases.at(i).second.size(); ++j)
+            file << (j == 0 ? "" : ", ") << bench->phases.at(i).second.at(j);
+        file << "]}";
+    }
+    file << std::endl << "  }" << std::endl << "}" << std::endl;
+}
@@ -1,36 +1,261 @@
 #include <bravo/bravo.hpp>
 
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
 #include <thread>
 #include <vector>
+#include <unistd.h>
 
 using namespace brv;
 
-void build::compile(const CmdContext *cctx) {
+void build::unify(const CmdContext *cctx) {
+    for (const ProjectContext *pctx : cctx->build_protocol) {
+        const ConfigContext *cfg = pctx->config;
+        BuildContext *bctx = pctx->build;
+        const size_t batch = cfg->unity_batch.value_or(BRV_UNITY_DEFAULT_BATCH);
+
+        // The entry stays alone so tests still link without it, excluded files and modules do not combine
+        std::set<fs::path> alone{};
+        for (const fs::path &path : cfg->unity_exclude)
+            alone.insert(fs::absolute(bctx->src_dir / path).lexically_normal());
+        if (cfg->entry.has_value())
+            alone.insert(fs::absolute(bctx->src_dir / cfg->entry.value()).lexically_normal());
+
+        // Batches follow directories so an edit only recompiles its neighbours, or balance sizes across the whole project
+        const bool sized = cfg->unity_group.value_or(BRV_UNITY_GROUP_DIRECTORY) == BRV_UNITY_GROUP_SIZE;
+        std::vector<fs::path> srcs{}, objs{};
+        std::map<fs::path, std::vector<fs::path>> dirs{};
+        for (size_t i = 0; i < bctx->src_files.size(); ++i) {
+            const fs::path &src = bctx->src_files.at(i);
+            if (!alone.contains(src.lexically_normal()) && src.extension() != BRV_FILE_EXT_MODULE) {
+                dirs[sized ? fs::path(".") : fs::relative(src.parent_path(), bctx->src_dir).lexically_normal()].push_back(src);
+                continue;
+            }
+            srcs.push_back(src);
+            objs.push_back(bctx->obj_files.at(i));
+        }
+
+        for (std::pair<const fs::path, std::vector<fs::path>> &pair : dirs) {
+            std::sort(pair.second.begin(), pair.second.end());
+            std::vector<std::vector<fs::path>> batches{};
+            if (sized) batches = balance(pair.second, batch);
+            for (size_t first = 0; !sized && first < pair.second.size(); first += batch)
+                batches.emplace_back(pair.second.begin() + first, pair.second.begin() + std::min(first + batch, pair.second.size()));
+
+            // Units mirror the source tree so directories never share a name
+            for (size_t i = 0; i < batches.size(); ++i) {
+                const fs::path unit = (bctx->obj_dir / BRV_DIR_UNITY / pair.first / (BRV_UNITY_STEM + std::to_string(i) + BRV_FILE_EXT_CPP)).lexically_normal();
+
+                writeUnity(unit, batches.at(i));
+                srcs.push_back(unit);
+                objs.push_back(fs::path(unit).replace_extension(BRV_FILE_EXT_OBJ));
+            }
+        }
+
+        BRV_CONDITIONAL(cctx->verbose, "Unity build of '", cfg->project_name, "' : ", bctx->src_files.size(), " source(s) in ", srcs.size(), " unit(s)!");
+        bctx->src_files = srcs;
+        bctx->obj_files = objs;
+    }
+}
+
+Profile build::profile(const CmdContext *cctx) {
+    // Profiles of the active project apply to every dependency so the whole tree links together
+    std::set<std::string> visited{};
+    const ProfileConfig config = resolveProfile(cctx->active_project->config, cctx->profile, visited);
+
+    // Archives carry no timestamps, uids or modes so an unchanged rebuild cuts the relinks after it off
+    Profile profile{cctx->profile, {"clang++", "-std=c++20", "-Wall", "-Wextra", "-Werror", "-pedantic-errors"}, {"clang++"}, BRV_ARCHIVER, {}, true};
+    if (config.opt.has_value()) profile.compile.push_back("-O" + config.opt.value());
+    if (config.debug.value_or(false)) profile.compile.push_back("-g");
+    if (config.march.has_value()) profile.compile.push_back("-march=" + config.march.value());
+    if (config.gc_sections.value_or(false)) {
+        profile.compile.insert(profile.compile.end(), {"-ffunction-sections", "-fdata-sections"});
+        profile.link.push_back(BRV_LINK_GC_SECTIONS);
+    }
+    lto(cctx, config, profile);
+    linker(cctx, config, profile);
+    for (const std::string &define : config.defines)
+        profile.compile.push_back("-D" + define);
+    profile.compile.insert(profile.compile.end(), config.flags.begin(), config.flags.end());
+    profile.link.insert(profile.link.end(), config.link_flags.begin(), config.link_flags.end());
+
+    // Instrumented binaries need the runtime at link time, the merged profile is only read by the compiler
+    if (!cctx->pgo_generate.empty()) {
+        profile.compile.push_back("-fprofile-generate=" + cctx->pgo_generate.string());
+        profile.link.push_back("-fprofile-generate=" + cctx->pgo_generate.string());
+    }
+    if (!cctx->pgo_use.empty())
+        profile.compile.insert(profile.compile.end(), {"-fprofile-use=" + cctx->pgo_use.string(),
+            "-Wno-profile-instr-out-of-date", "-Wno-profile-instr-unprofiled"});
+    return profile;
+}
+
+void build::lto(const CmdContext *cctx, const ProfileConfig &config, Profile &profile) {
+    const std::string mode = config.lto.value_or(BRV_LTO_OFF);
+    if (mode == BRV_LTO_OFF) return;
+
+    // Objects hold bitcode, archives need an index GNU ar cannot read from them, Apple's libtool reads it through libLTO
+    const std::string flag = mode == BRV_LTO_THIN ? "-flto=thin" : "-flto";
+    profile.compile.push_back(flag);
+    profile.link.push_back(flag);
+    profile.archive.front() = BRV_LTO_ARCHIVER;
+    if (mode != BRV_LTO_THIN) return;
+
+    // Modules whose summary and imports did not change are taken from the cache on relink
+    const fs::path cache = cctx->active_project->build->obj_dir / BRV_DIR_LTO_CACHE;
+    fs::create_directories(cache);
+    profile.link.insert(profile.link.end(), {BRV_LTO_CACHE_DIR + cache.string(), BRV_LTO_CACHE_POLICY});
+}
+
+void build::linker(const CmdContext *cctx, const ProfileConfig &config, Profile &profile) {
+    // Profiles choose before the project, thin LTO needs a linker that keeps its cache
+    const std::string fallback = config.lto == BRV_LTO_THIN ? BRV_LTO_THIN_LINKER : BRV_LINKER_SYSTEM;
+    const std::string name = config.linker.value_or(cctx->active_project->config->linker.value_or(fallback));
+    if (name != BRV_LINKER_SYSTEM) {
+        profile.link.push_back("-fuse-ld=" + name);
+
+        // An upgraded linker may lay out the same inputs differently, its binary is a link input.
+        // Clang looks for 'ld64.<name>' when targeting Apple platforms and 'ld.<name>' elsewhere.
+        const fs::path path = proc::which(BRV_LINKER_PREFIX + name);
+        BRV_ASSERT(!path.empty(), "Linker '", name, "' was not found in PATH as '", BRV_LINKER_PREFIX, name, "'.");
+        profile.link_inputs.push_back(path);
+    }
+
+    // Debug info stays in .dwo files next to the objects, the cache only stores objects so it is skipped
+    if (config.debug.value_or(false) && config.split_debug.value_or(false)) {
+        profile.compile.push_back("-gsplit-dwarf");
+        if (name != BRV_LINKER_SYSTEM) profile.link.push_back(BRV_LINK_GDB_INDEX);
+        profile.cacheable = false;
+    }
+    if (config.debug.value_or(false) && config.compress_debug.value_or(false)) {
+        profile.compile.push_back("-gz");
+        profile.link.push_back("-gz");
+    }
+}
+
+ProfileConfig build::resolveProfile(const ConfigContext *cfg, const std::string &name, std::set<std::string> &visited) {
+    const std::map<std::string, ProfileConfig>::const_iterator own = cfg->profiles.find(name);
+    const std::map<std::string, ProfileConfig>::const_iterator builtin = PROFILE_MAP.find(name);
+    if (own == cfg->profiles.end()) {
+        BRV_ASSERT(builtin != PROFILE_MAP.end(), "Unknown profile '", name, "'.");
+        return builtin->second;
+    }
+    BRV_ASSERT(visited.insert(name).second, "Profile '", name, "' inherits from itself through a cycle.");
+
+    // A config profile named like a built-in one extends it unless it says otherwise, naming itself means the built-in
+    ProfileConfig profile{};
+    const std::optional<std::string> &inherits = own->second.inherits;
+    if (inherits.has_value() && inherits.value() != name) {
+        profile = resolveProfile(cfg, inherits.value(), visited);
+    } else if (builtin != PROFILE_MAP.end()) {
+        profile = builtin->second;
+    } else {
+        BRV_ASSERT(!inherits.has_value(), "Profile '", name, "' inherits itself.");
+    }
+
+    const ProfileConfig &config = own->second;
+    if (config.opt.has_value()) profile.opt = config.opt;
+    if (config.march.has_value()) profile.march = config.march;
+    if (config.lto.has_value()) profile.lto = config.lto;
+    if (config.linker.has_value()) profile.linker = config.linker;
+    if (config.debug.has_value()) profile.debug = config.debug;
+    if (config.gc_sections.has_value()) profile.gc_sections = config.gc_sections;
+    if (config.split_debug.has_value()) profile.split_debug = config.split_debug;
+    if (config.compress_debug.has_value()) profile.compress_debug = config.compress_debug;
+    profile.defines.insert(profile.defines.end(), config.defines.begin(), config.defines.end());
+    profile.flags.insert(profile.flags.end(), config.flags.begin(), config.flags.end());
+    profile.link_flags.insert(profile.link_flags.end(), config.link_flags.begin(), config.link_flags.end());
+    return profile;
+}
+
+std::vector<std::vector<fs::path>> build::balance(const std::vector<fs::path> &srcs, size_t batch) {
+    std::vector<uint64_t> sizes{};
+    uint64_t total = 0;
+    for (const fs::path &src : srcs)
+        total += sizes.emplace_back(std::max<uint64_t>(file::stat(src).size, 1));
+
+    // As many units as batches of 'unity_batch' files, a file goes to the unit its midpoint falls in by bytes
+    const size_t count = (srcs.size() + batch - 1) / batch;
+    std::vector<std::vector<fs::path>> batches(1);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < srcs.size(); ++i) {
+        if (!batches.back().empty() && batches.size() < count && sum + sizes.at(i) / 2 >= total * batches.size() / count)
+            batches.emplace_back();
+        batches.back().push_back(srcs.at(i));
+        sum += sizes.at(i);
+    }
+    return batches;
+}
+
+bool build::writeUnity(const fs::path &dst, const std::vector<fs::path> &srcs) {
+    std::ostringstream content;
+    for (const fs::path &src : srcs)
+        content << "#include " << file::quote(src.string()) << std::endl;
+    return file::update(dst, content.str());
+}
+
+void build::compile(const CmdContext *cctx, BuildGraph *graph) {
 
     BRV_CONDITIONAL(cctx->verbose, "Preparing compilation:");
 
-    std::string base = "clang++ -std=c++20 -Wall -Wextra -Werror -pedantic-errors"; // tmp
+    graph->profile = profile(cctx);
+    BRV_CONDITIONAL(cctx->verbose, "Using profile '", graph->profile.name, "'.");
+
+    const Argv base = graph->profile.compile;
+
+    // Only writes under the directories the watch daemon follows are reported to it
+    if (graph->changed != nullptr)
+        for (const ProjectContext *pctx : cctx->build_protocol)
+            for (const fs::path &dir : watch::inputs(pctx))
+                graph->watched.push_back(dir);
+
+    scan(cctx, graph, base);
 
-    std::vector<std::string> cmds;
     for (const ProjectContext *pctx : cctx->build_protocol) {
 
         BRV_CONDITIONAL(cctx->verbose, "Enumerating source files for '", pctx->config->project_name, "':");
 
-        std::ostringstream common;
-        common << base;
-        for (const fs::path &dir : pctx->build->include_dirs)
-            common << " -I" << dir;
+        state::load(pctx->build->state);
+        const uint64_t average = state::averageRss(pctx->build->state);
+        const uint64_t duration = state::averageDuration(pctx->build->state);
 
-        const unsigned int size = pctx->build->src_files.size();
+        Argv common = commonFlags(cctx, graph, pctx, base);
 
-        for (unsigned int i = 0; i < size; ++i) {
+        // A fresh precompiled header goes first and invalidates every unit that loads it
+        Action *pch = precompile(cctx, graph, pctx, common, base);
+        Argv pre = common;
+        usePch(pctx->build, common, pre);
+
+        // Interfaces come first so a rebuilt module reaches its importers in a single pass
+        for (const size_t i : order(graph, pctx->build->src_files)) {
             const fs::path src = pctx->build->src_files.at(i);
             const fs::path dst = pctx->build->obj_files.at(i);
 
-            if (cctx->rebuild || rebuild(src, dst)) {
+            Argv cmd = makeCompileCommand(common, src, dst);
+            bool missing = false;
+            if (graph->provides.contains(src)) {
+                const fs::path out = bmi(pctx->build, graph->provides.at(src));
+                fs::create_directories(out.parent_path());
+                cmd.push_back("-fmodule-output=" + out.string());
+                missing = !file::isfile(out);
+            }
+
+            if (cctx->rebuild || pch != nullptr || missing || importsRebuilt(graph, src) || rebuild(graph, src, dst, cmd, pctx->build->state)) {
                 BRV_CONDITIONAL(cctx->verbose, "Adding : ", src.filename());
-                cmds.emplace_back(makeCompileCommand(common.str(), src, dst));
+                graph->jobs.push_back({src, dst, cmd, makePreprocessCommand(pre, src, dst), base, pctx->build->state, pctx->config->root});
+                graph->jobs.back().memory = predict(pctx->build->state, dst, average);
+                graph->jobs.back().cost = estimate(pctx->build->state, dst, duration);
+                if (graph->provides.contains(src) || graph->imports.contains(src))
+                    graph->jobs.back().pre.clear();
+                graph->objects[pctx].push_back(plan(cctx, graph, &graph->jobs.back()));
+                if (pch != nullptr) sched::depend(graph->objects[pctx].back(), pch);
+                bindModules(graph, graph->objects[pctx].back(), src);
                 continue;
             }
             BRV_CONDITIONAL(cctx->verbose, "Skipping : ", src.filename());
@@ -42,74 +267,339 @@ void build::compile(const CmdContext *cctx) {
     if (!bctx->test_src_files.empty()) {
         BRV_CONDITIONAL(cctx->verbose, "Enumerating test files for '", cctx->active_project->config->project_name, "':");
 
-        std::ostringstream common;
-        common << base;
-        for (const fs::path &dir : bctx->include_dirs)
-            common << " -I" << dir;
+        Argv common = commonFlags(cctx, graph, cctx->active_project, base);
+
+        Action *pch = graph->pch.contains(cctx->active_project) ? graph->pch.at(cctx->active_project) : nullptr;
+        Argv pre = common;
+        usePch(bctx, common, pre);
 
         const unsigned int size = bctx->test_src_files.size();
 
         for (unsigned int i = 0; i < size; ++i) {
             const fs::path src = bctx->test_src_files.at(i);
             const fs::path dst = bctx->test_obj_files.at(i);
-            if (cctx->rebuild || rebuild(src, dst)) {
+            if (!selected(cctx, src)) continue;
+
+            const Argv cmd = makeCompileCommand(common, src, dst);
+            if (cctx->rebuild || pch != nullptr || importsRebuilt(graph, src) || rebuild(graph, src, dst, cmd, bctx->state)) {
                 BRV_CONDITIONAL(cctx->verbose, "Adding : ", src.filename());
-                cmds.emplace_back(makeCompileCommand(common.str(), src, dst));
+                graph->jobs.push_back({src, dst, cmd, makePreprocessCommand(pre, src, dst), base, bctx->state, cctx->active_project->config->root});
+                graph->jobs.back().memory = predict(bctx->state, dst, state::averageRss(bctx->state));
+                graph->jobs.back().cost = estimate(bctx->state, dst, state::averageDuration(bctx->state));
+                if (graph->imports.contains(src))
+                    graph->jobs.back().pre.clear();
+                graph->tests[dst] = plan(cctx, graph, &graph->jobs.back());
+                if (pch != nullptr) sched::depend(graph->tests[dst], pch);
+                bindModules(graph, graph->tests[dst], src);
                 continue;
             }
             BRV_CONDITIONAL(cctx->verbose, "Skipping : ", src.filename());
         }
     }
 
-    std::vector<std::thread> workers{};
-    std::atomic<size_t> index = 0;
+    if (!graph->jobs.empty() && !cctx->time_trace && graph->profile.cacheable)
+        graph->cache = cache::open(base.front());
+    if (graph->cache != nullptr)
+        BRV_CONDITIONAL(cctx->verbose, "Using compilation cache ", graph->cache->dir);
+
+    BRV_CONDITIONAL(cctx->verbose, "Planned ", graph->jobs.size(), " compilation(s)!");
+}
+
+Action *build::plan(const CmdContext *cctx, BuildGraph *graph, CompileJob *job) {
+    const bool verbose = cctx->verbose;
+    Action *action = sched::add(graph, job->src.filename().string(), [=](Action *action) {
+        Process *compile = new Process();
+        compile->argv = job->cmd;
+        compile->name = job->src.filename().string();
+        compile->category = "compile";
+        compile->memory = job->memory;
+        compile->priority = action->priority;
+        compile->on_exit = [=](Process *proc) {
+            std::cerr << proc->output;
+            if (proc->status != EXIT_SUCCESS) {
+                BRV_ERROR("Failed to compile ", job->src.filename(), ".");
+                graph->exec.failed = true;
+                return;
+            }
+            if (graph->cache != nullptr && job->key != 0)
+                cache::store(graph->cache, job->key, job->obj);
+
+            sign(graph, job, proc);
+            BRV_CONDITIONAL(verbose, "Compiled ", job->src.filename(), " (", ++graph->compiled, "/", graph->jobs.size(), ")");
+            sched::complete(graph, action);
+        };
+
+        // Never write through a hardlink into the cache
+        fs::remove(job->obj);
+
+        // Precompiled headers and module units have no self-contained preprocessed form to key on
+        if (graph->cache == nullptr || job->pre.empty()) {
+            proc::submit(&graph->exec, compile);
+            return;
+        }
+
+        // Preprocess first, the cache key depends on the expanded source
+        Process *pre = new Process();
+        pre->argv = job->pre;
+        pre->name = job->src.filename().string();
+        pre->category = "preprocess";
+        pre->priority = action->priority;
+        pre->on_exit = [=](Process *proc) {
+            job->key = proc->status == EXIT_SUCCESS ? cache::key(graph->cache, *job) : 0;
+            if (job->key != 0 && cache::fetch(graph->cache, job->key, job->obj)) {
+                sign(graph, job, nullptr);
+                BRV_CONDITIONAL(verbose, "Restored ", job->src.filename(), " from cache (", ++graph->compiled, "/", graph->jobs.size(), ")");
+                delete compile;
+                sched::complete(graph, action);
+                return;
+            }
+            proc::submit(&graph->exec, compile, true);
+        };
+        proc::submit(&graph->exec, pre);
+    });
+    action->cost = job->cost;
+    return action;
+}
+
+Argv build::commonFlags(const CmdContext *cctx, const BuildGraph *graph, const ProjectContext *pctx, const Argv &base) {
+    Argv common = base;
+    for (const fs::path &dir : pctx->build->include_dirs)
+        common.push_back("-I" + dir.string());
 
-    const unsigned int thread_count = threadCount(cmds);
-    BRV_CONDITIONAL(cctx->verbose, "Starting compilation with ", thread_count, " thread(s):");
+    // Debug info names sources relative to their project so objects are the same from any checkout
+    common.insert(common.end(), {"-fdebug-compilation-dir=.", "-fdebug-prefix-map=" + pctx->config->root.string() + "=."});
 
-    for (unsigned int i = 0; i < thread_count; ++i)
-        workers.emplace_back(std::thread(worker, i, cctx->verbose, std::cref(cmds), std::ref(index)));
+    // Clang writes the trace next to the object file
+    if (cctx->time_trace)
+        common.insert(common.end(), {"-ftime-trace", "-ftime-trace-granularity=" + std::to_string(BRV_ANALYZE_GRANULARITY_US)});
+
+    // Interfaces of every project are found by module name, including those of dependencies
+    if (graph->modular)
+        for (const ProjectContext *project : cctx->build_protocol)
+            common.push_back("-fprebuilt-module-path=" + project->build->module_dir.string());
+    return common;
+}
+
+void build::scan(const CmdContext *cctx, BuildGraph *graph, const Argv &base) {
+    // Modules stay off until a project declares an interface
+    for (const ProjectContext *pctx : cctx->build_protocol)
+        for (const fs::path &src : pctx->build->src_files)
+            graph->modular = graph->modular || src.extension() == BRV_FILE_EXT_MODULE;
+    if (!graph->modular) return;
+
+    const BuildContext *active = cctx->active_project->build;
+    const fs::path db = active->obj_dir / BRV_FILE_NAME_SCAN_DB;
+    const fs::path out = active->obj_dir / BRV_FILE_NAME_SCAN;
+
+    // One compilation database entry per unit, scanned with the flags it compiles with
+    std::unordered_map<fs::path, fs::path> sources{};
+    std::unordered_map<fs::path, BuildState *> states{};
+    std::ostringstream str;
+    str << "[";
+    const auto entry = [&](const ProjectContext *pctx, const fs::path &src, const fs::path &obj) {
+        Argv cmd = commonFlags(cctx, graph, pctx, base);
+        cmd.insert(cmd.end(), {"-c", src.string(), "-o", obj.string()});
+
+        str << (sources.empty() ? "" : ",") << std::endl << "{\"directory\": " << file::quote(pctx->config->root.string())
+            << ", \"file\": " << file::quote(src.string()) << ", \"output\": " << file::quote(obj.string()) << ", \"arguments\": [";
+        for (size_t i = 0; i < cmd.size(); ++i)
+            str << (i == 0 ? "" : ", ") << file::quote(cmd[i]);
+        str << "]}";
+        sources[obj] = src;
+        states[obj] = pctx->build->state;
+    };
+    for (const ProjectContext *pctx : cctx->build_protocol)
+        for (size_t i = 0; i < pctx->build->src_files.size(); ++i)
+            entry(pctx, pctx->build->src_files.at(i), pctx->build->obj_files.at(i));
+    for (size_t i = 0; i < active->test_src_files.size(); ++i)
+        entry(cctx->active_project, active->test_src_files.at(i), active->test_obj_files.at(i));
+    str << std::endl << "]" << std::endl;
+
+    // The last scan holds while no unit nor header it includes changed since, an import may come from either
+    bool fresh = !file::update(db, str.str()) && file::isfile(out);
+    if (fresh) {
+        const int64_t time = file::stat(out).mtime;
+        const auto stale = [&](const fs::path &path) {
+            const FileStat &in = file::stat(path, graph->stats);
+            return !in.exists || in.mtime >= time;
+        };
+        for (const std::pair<const fs::path, fs::path> &pair : sources) {
+            // Headers come from the depfile of the last compile, a unit without one is scanned again
+            BuildState *state = states.at(pair.first);
+            ActionRecord *record = state::find(state, pair.first);
+            const std::vector<fs::path> *headers = record == nullptr ? nullptr : state::prereqs(state, record, pair.first);
+            if (stale(pair.second) || headers == nullptr || std::any_of(headers->begin(), headers->end(), stale)) {
+                fresh = false;
+                break;
+            }
+        }
+    }
 
-    for (std::thread &worker : workers)
-        worker.join();
+    if (!fresh) {
+        BRV_CONDITIONAL(cctx->verbose, "Scanning module dependencies of ", sources.size(), " unit(s)!");
+        std::string output;
+        const int status = proc::capture({"clang-scan-deps", "-format=p1689", "-compilation-database", db.string(), "-o", out.string()}, output);
+        if (status != EXIT_SUCCESS) fs::remove(out);
+        BRV_ASSERT(status == EXIT_SUCCESS, "Failed to scan module dependencies :\n", output);
+    }
 
-    BRV_CONDITIONAL(cctx->verbose, "All workers done; compiled ", cmds.size(), " file(s)!");
+    readScan(graph, out, sources);
+    BRV_CONDITIONAL(cctx->verbose, "Found ", graph->provides.size(), " module interface(s)!");
 }
 
-void build::worker(unsigned int id, bool verbose, const std::vector<std::string> &cmds, std::atomic<size_t> &index) {
-    BRV_CONDITIONAL(verbose, "Dispached worker thread with id : ", id);
-    while (true) {
-        size_t i = index.fetch_add(1);
-        if (i >= cmds.size()) break;
+void build::readScan(BuildGraph *graph, const fs::path &path, const std::unordered_map<fs::path, fs::path> &sources) {
+    jltt::Parser *parser = new jltt::Parser(path);
+    BRV_ASSERT(parser->state() == jltt::STATE_OPEN, "Failed to open module scan ", path, ".");
+    parser->start();
+    BRV_ASSERT(parser->state() == jltt::STATE_SUCCESS, "Failed to parse module scan ", path, ".");
+
+    jltt::JValue *json = parser->root();
+    delete parser;
+
+    // P1689 : one rule per unit with the module it provides and those it requires
+    jltt::JValue *rules = json->at("rules");
+    BRV_ASSERT(rules != nullptr && rules->is<jltt::JArray>(), "Invalid module scan ", path, ".");
+
+    for (jltt::JValue *rule : *rules->as<jltt::JArray>()) {
+        jltt::JValue *output = rule->at("primary-output");
+        if (output == nullptr || !output->is<jltt::JString>()) continue;
 
-        int exit_code = std::system(cmds[i].c_str());
-        BRV_ASSERT(exit_code == EXIT_SUCCESS, "Worker [", id, "] Failed to compile build command.");
+        const std::unordered_map<fs::path, fs::path>::const_iterator it = sources.find(fs::path(*output->as<jltt::JString>()));
+        if (it == sources.end()) continue;
 
-        BRV_CONDITIONAL(verbose, "Worker [", id, "] ended task (", i+1, "/", cmds.size(), ")");
+        jltt::JValue *provides = rule->at("provides");
+        if (provides != nullptr && provides->is<jltt::JArray>())
+            for (jltt::JValue *module : *provides->as<jltt::JArray>()) {
+                jltt::JValue *name = module->at("logical-name");
+                if (name != nullptr && name->is<jltt::JString>())
+                    graph->provides[it->second] = *name->as<jltt::JString>();
+            }
+
+        jltt::JValue *requires_ = rule->at("requires");
+        if (requires_ != nullptr && requires_->is<jltt::JArray>())
+            for (jltt::JValue *module : *requires_->as<jltt::JArray>()) {
+                jltt::JValue *name = module->at("logical-name");
+                if (name != nullptr && name->is<jltt::JString>())
+                    graph->imports[it->second].push_back(*name->as<jltt::JString>());
+            }
     }
-    BRV_CONDITIONAL(verbose, "Worker [", id, "] done!");
+
+    delete json;
+}
+
+std::vector<size_t> build::order(const BuildGraph *graph, const std::vector<fs::path> &srcs) {
+    std::vector<size_t> order{};
+    std::vector<bool> seen(srcs.size(), false);
+
+    std::unordered_map<std::string, size_t> providers{};
+    for (size_t i = 0; i < srcs.size(); ++i)
+        if (graph->provides.contains(srcs[i]))
+            providers[graph->provides.at(srcs[i])] = i;
+
+    // Each interface after the interfaces it imports, then every other unit in place
+    const std::function<void(size_t)> visit = [&](size_t i) {
+        if (seen[i]) return;
+        seen[i] = true;
+        if (graph->imports.contains(srcs[i]))
+            for (const std::string &name : graph->imports.at(srcs[i]))
+                if (providers.contains(name))
+                    visit(providers.at(name));
+        order.push_back(i);
+    };
+    for (const std::pair<const std::string, size_t> &pair : providers)
+        visit(pair.second);
+    for (size_t i = 0; i < srcs.size(); ++i)
+        if (!seen[i])
+            order.push_back(i);
+
+    return order;
+}
+
+bool build::importsRebuilt(const BuildGraph *graph, const fs::path &src) {
+    if (!graph->imports.contains(src)) return false;
+    for (const std::string &name : graph->imports.at(src))
+        if (graph->modules.contains(name))
+            return true;
+    return false;
+}
+
+void build::bindModules(BuildGraph *graph, Action *action, const fs::path &src) {
+    if (graph->imports.contains(src))
+        for (const std::string &name : graph->imports.at(src))
+            if (graph->modules.contains(name))
+                sched::depend(action, graph->modules.at(name));
+
+    if (graph->provides.contains(src))
+        graph->modules[graph->provides.at(src)] = action;
+}
+
+fs::path build::bmi(const BuildContext *bctx, const std::string &name) {
+    // Partitions 'M:part' are looked up as 'M-part.pcm' in prebuilt module paths
+    std::string file = name;
+    std::replace(file.begin(), file.end(), ':', '-');
+    return bctx->module_dir / (file + BRV_FILE_EXT_BMI);
 }
 
-void build::link(const CmdContext *cctx) {
+Action *build::precompile(const CmdContext *cctx, BuildGraph *graph, const ProjectContext *pctx, const Argv &common, const Argv &base) {
+    const BuildContext *bctx = pctx->build;
+    if (bctx->pch_src.empty()) return nullptr;
+
+    const Argv cmd = makePrecompileCommand(common, bctx->pch_src, bctx->pch_dst);
+    if (!cctx->rebuild && !rebuild(graph, bctx->pch_src, bctx->pch_dst, cmd, bctx->state)) {
+        BRV_CONDITIONAL(cctx->verbose, "Skipping : ", bctx->pch_src.filename(), " (precompiled)");
+        return nullptr;
+    }
 
-    BRV_CONDITIONAL(cctx->verbose, "Starting linking protocol:");
+    BRV_CONDITIONAL(cctx->verbose, "Adding : ", bctx->pch_src.filename(), " (precompiled)");
+    graph->jobs.push_back({bctx->pch_src, bctx->pch_dst, cmd, {}, base, bctx->state, pctx->config->root});
+    graph->jobs.back().memory = predict(bctx->state, bctx->pch_dst, state::averageRss(bctx->state));
+    graph->jobs.back().cost = estimate(bctx->state, bctx->pch_dst, state::averageDuration(bctx->state));
+
+    Action *action = plan(cctx, graph, &graph->jobs.back());
+    graph->pch[pctx] = action;
+    return action;
+}
+
+void build::usePch(const BuildContext *bctx, Argv &common, Argv &pre) {
+    if (bctx->pch_src.empty()) return;
+
+    // Preprocessing expands the header itself so cache keys still see its content
+    common.insert(common.end(), {"-include-pch", bctx->pch_dst.string()});
+    pre.insert(pre.end(), {"-include", bctx->pch_src.string()});
+}
+
+void build::link(const CmdContext *cctx, BuildGraph *graph) {
+
+    BRV_CONDITIONAL(cctx->verbose, "Preparing linking protocol:");
 
     std::vector<fs::path> archs{};
-    int proj = 0;
+    std::vector<Action *> arch_actions{};
     for (const ProjectContext *pctx : cctx->build_protocol) {
 
-        BRV_CONDITIONAL(cctx->verbose, "Linking project '", pctx->config->project_name, "' (", ++proj, "/", cctx->build_protocol.size(), ")");
-
         LinkProcess process = LINK_PROCESS_MAP.at(pctx->config->project_type);
 
-        const std::string cmd = process(pctx->build->obj_files, archs, pctx->build->end_dst);
+        const Argv cmd = process(graph->profile, pctx->build->obj_files, archs, pctx->build->end_dst);
 
         fs::create_directories(pctx->build->bin_dir);
 
-        BRV_ASSERT(std::system(cmd.c_str()) == EXIT_SUCCESS, "Failed to link project '", pctx->config->project_name, "'.");
-    }
+        std::vector<fs::path> inputs = pctx->build->obj_files;
+        if (pctx->config->project_type == BRV_PROJECT_TYPE_EXEC) {
+            inputs.insert(inputs.end(), archs.begin(), archs.end());
+            inputs.insert(inputs.end(), graph->profile.link_inputs.begin(), graph->profile.link_inputs.end());
+        }
 
-    BRV_CONDITIONAL(cctx->verbose, "Starting test linking:");
+        Action *action = plan(cctx, graph, cmd, pctx->config->project_name, inputs, pctx->build->end_dst, pctx->build->state);
+        for (Action *dep : graph->objects[pctx])
+            sched::depend(action, dep);
+
+        // Archives only need their own objects, executables need every archive before them
+        if (pctx->config->project_type == BRV_PROJECT_TYPE_STATIC) {
+            arch_actions.push_back(action);
+            continue;
+        }
+        for (Action *dep : arch_actions)
+            sched::depend(action, dep);
+    }
 
     const BuildContext *bctx = cctx->active_project->build;
     const ConfigContext *cfg = cctx->active_project->config;
@@ -125,64 +615,371 @@ void build::link(const CmdContext *cctx) {
     for (const fs::path &arch : archs)
         objs.emplace_back(arch);
 
+    // Test links are independent actions, the executor runs them side by side
+    unsigned int tests = 0;
     for (const fs::path &test : bctx->test_obj_files) {
+        if (!selected(cctx, test)) continue;
+        ++tests;
 
-        BRV_CONDITIONAL(cctx->verbose, "Linking test ", test.filename(), ".");
-
-        fs::path dst = bctx->test_dir / BRV_DIR_BIN / fs::relative(
+        fs::path dst = bctx->test_bin_dir / fs::relative(
             test,
-            bctx->test_dir / BRV_DIR_OBJ
+            bctx->test_obj_dir
         ).replace_extension(BRV_FILE_EXT_EXE);
-        const std::string cmd = linkExec({ test }, objs, dst);
+        const Argv cmd = linkExec(graph->profile, { test }, objs, dst);
         fs::create_directories(dst.parent_path());
-        BRV_ASSERT(std::system(cmd.c_str()) == EXIT_SUCCESS, "Failed to link test ", test.filename(), ".");
+
+        std::vector<fs::path> inputs = objs;
+        inputs.push_back(test);
+        inputs.insert(inputs.end(), graph->profile.link_inputs.begin(), graph->profile.link_inputs.end());
+
+        Action *action = plan(cctx, graph, cmd, "test " + test.filename().string(), inputs, dst, bctx->state);
+        if (graph->tests.contains(test))
+            sched::depend(action, graph->tests.at(test));
+        for (Action *dep : graph->objects[cctx->active_project])
+            sched::depend(action, dep);
+        for (Action *dep : arch_actions)
+            sched::depend(action, dep);
     }
 
-    BRV_CONDITIONAL(cctx->verbose, "Linking done; ", cctx->build_protocol.size(), " projects linked!");
+    BRV_CONDITIONAL(cctx->verbose, "Planned ", cctx->build_protocol.size(), " project link(s) and ", tests, " test link(s)!");
 }
 
-std::string build::linkExec(const std::vector<fs::path> &objs, std::vector<fs::path> &archs, const fs::path &dst) {
-    std::ostringstream cmd;
+Action *build::plan(const CmdContext *cctx, BuildGraph *graph, const Argv &cmd, const std::string &name, const std::vector<fs::path> &inputs, const fs::path &dst, BuildState *state) {
+    const bool verbose = cctx->verbose;
+    Action *action = sched::add(graph, name, [=](Action *action) {
+        // Inputs are final once the dependencies completed, unchanged ones cut the relink off
+        if (linked(graph, cmd, inputs, dst, state)) {
+            BRV_CONDITIONAL(verbose, "Skipping link of ", name, ", up to date!");
+            sched::complete(graph, action);
+            return;
+        }
+        fs::remove(dst);
+
+        Process *link = new Process();
+        link->argv = cmd;
+        link->name = name;
+        link->category = "link";
+        link->priority = action->priority;
+        link->on_exit = [=](Process *proc) {
+            std::cerr << proc->output;
+            if (proc->status != EXIT_SUCCESS) {
+                BRV_ERROR("Failed to link ", name, ".");
+                graph->exec.failed = true;
+                return;
+            }
 
-    cmd << "clang++ -std=c++20 -Wall -Wextra -Werror -pedantic-errors"; // tmp
-    cmd << " -o " << dst;
+            ActionRecord record{};
+            record.command = hash::argv(cmd);
+            record.content = digest(inputs, state, graph->memo);
+            record.peak_rss = proc->peak_rss;
+            record.cpu_ms = proc->cpu_ms;
+            record.duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(proc->end - proc->start).count();
+            state::record(state, dst, record);
+
+            BRV_CONDITIONAL(verbose, "Linked ", name, "!");
+            sched::complete(graph, action);
+        };
+        proc::submit(&graph->exec, link);
+    });
+    action->cost = estimate(state, dst, BRV_SCHED_DEFAULT_LINK_MS);
+    return action;
+}
 
-    for (const fs::path &arch : archs)
-        cmd << " " << arch;
+bool build::linked(BuildGraph *graph, const Argv &cmd, const std::vector<fs::path> &inputs, const fs::path &dst, BuildState *state) {
+    // Inputs were just rebuilt, their stats cannot come from the memo
+    const FileStat out = file::stat(dst);
+    if (!out.exists) return false;
 
-    for (const fs::path &obj : objs)
-        cmd << " " << obj;
+    const ActionRecord *record = state::find(state, dst);
+    if (record == nullptr || record->command != hash::argv(cmd)) return false;
 
-    return cmd.str();
+    bool touched = false;
+    for (const fs::path &input : inputs) {
+        const FileStat in = file::stat(input);
+        if (!in.exists) return false;
+        if (in.mtime >= out.mtime) touched = true;
+    }
+    if (!touched) return true;
+
+    // Rebuilt inputs that came out byte-identical do not need a relink
+    if (digest(inputs, state, graph->memo) != record->content) return false;
+
+    file::touch(dst);
+    return true;
+}
+
+void build::execute(const CmdContext *cctx, BuildGraph *graph) {
+    proc::configure(cctx, &graph->exec);
+    BRV_CONDITIONAL(cctx->verbose, "Starting build with ", graph->exec.jobs, " job(s):");
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    sched::run(graph);
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (graph->cache != nullptr) {
+        BRV_INFO("Compilation cache : ", graph->cache->hits, " hit(s), ", graph->cache->misses, " miss(es).");
+        cache::evict(graph->cache);
+        delete graph->cache;
+        graph->cache = nullptr;
+    }
+
+    // Keep the signatures of whatever succeeded, even on failure
+    for (const ProjectContext *pctx : cctx->build_protocol)
+        state::save(pctx->build->state);
+
+    if (cctx->verbose) {
+        report(graph);
+        BRV_INFO("Critical path : ", tests::seconds(sched::criticalPath(graph, true) / 1000), " (predicted ",
+            tests::seconds(sched::criticalPath(graph, false) / 1000), "), wall time : ", tests::seconds(wall));
+    }
+
+    BRV_ASSERT(!graph->exec.failed, "Build failed.");
+    BRV_CONDITIONAL(cctx->verbose, "Build done; ", graph->actions.size(), " action(s) executed!");
 }
 
-std::string build::linkStatic(const std::vector<fs::path> &objs, std::vector<fs::path> &archs, const fs::path &dst) {
-    std::ostringstream cmd;
+Argv build::linkExec(const Profile &profile, const std::vector<fs::path> &objs, std::vector<fs::path> &archs, const fs::path &dst) {
+    Argv cmd = profile.link;
+    cmd.insert(cmd.end(), {"-o", dst.string()});
+
+    for (const fs::path &obj : objs)
+        cmd.push_back(obj.string());
+
+    // Objects first, then archives with dependents before their dependencies for single pass linkers
+    for (const fs::path &arch : archs)
+        if (arch.extension() != BRV_FILE_EXT_ARCHIVE)
+            cmd.push_back(arch.string());
+    for (std::vector<fs::path>::const_reverse_iterator it = archs.rbegin(); it != archs.rend(); ++it)
+        if (it->extension() == BRV_FILE_EXT_ARCHIVE)
+            cmd.push_back(it->string());
+
+    return cmd;
+}
 
-    cmd << "ar rcs " << dst;
+Argv build::linkStatic(const Profile &profile, const std::vector<fs::path> &objs, std::vector<fs::path> &archs, const fs::path &dst) {
+    Argv cmd = profile.archive;
+    cmd.push_back(dst.string());
 
     archs.emplace_back(dst);
 
     for (const fs::path &obj : objs)
-        cmd << " " << obj;
+        cmd.push_back(obj.string());
+
+    return cmd;
+}
 
-    return cmd.str();
+Argv build::makeCompileCommand(const Argv &common, const fs::path &src, const fs::path &dst) {
+    fs::create_directories(dst.parent_path());
+    Argv cmd = common;
+    cmd.insert(cmd.end(), {"-c", src.string()});
+    cmd.insert(cmd.end(), {"-o", dst.string()});
+    cmd.insert(cmd.end(), {"-MMD", "-MF", fs::path(dst).replace_extension(BRV_FILE_EXT_DEP).string()});
+    return cmd;
+}
+
+Argv build::makePreprocessCommand(const Argv &common, const fs::path &src, const fs::path &dst) {
+    Argv cmd = common;
+    cmd.insert(cmd.end(), {"-E", src.string()});
+    cmd.insert(cmd.end(), {"-o", fs::path(dst).replace_extension(BRV_FILE_EXT_PRE).string()});
+    cmd.insert(cmd.end(), {"-MMD", "-MF", fs::path(dst).replace_extension(BRV_FILE_EXT_DEP).string()});
+    cmd.insert(cmd.end(), {"-MT", dst.string()});
+    return cmd;
 }
 
-std::string build::makeCompileCommand(const std::string &common, const fs::path &src, const fs::path &dst) {
+Argv build::makePrecompileCommand(const Argv &common, const fs::path &src, const fs::path &dst) {
     fs::create_directories(dst.parent_path());
-    std::ostringstream cmd;
-    cmd << common;
-    cmd << " -c " << src;
-    cmd << " -o " << dst;
-    return cmd.str();
+    Argv cmd = common;
+    cmd.insert(cmd.end(), {"-x", "c++-header", src.string()});
+    cmd.insert(cmd.end(), {"-o", dst.string()});
+    cmd.insert(cmd.end(), {"-MMD", "-MF", fs::path(dst).replace_extension(BRV_FILE_EXT_DEP).string()});
+    return cmd;
+}
+
+bool build::rebuild(BuildGraph *graph, const fs::path &src, const fs::path &obj, const Argv &cmd, BuildState *state) {
+    const FileStat out = file::stat(obj);
+    if (!out.exists) return true;
+
+    ActionRecord *record = state::find(state, obj);
+    if (record == nullptr || record->command != hash::argv(cmd)) return true;
+
+    // The watch daemon saw every input written since its last build, untouched units need no further stat
+    // Unity units and headers outside the watched directories were never reported, they take the stat path below
+    const auto written = [graph](const fs::path &path) { return graph->changed->contains(path.lexically_normal()); };
+    const auto watched = [graph](const fs::path &path) { return watch::covers(graph->watched, path); };
+    if (graph->changed != nullptr && record->depfile != 0 && watched(src) && !written(src)
+        && std::all_of(record->prereqs.begin(), record->prereqs.end(), watched)
+        && std::none_of(record->prereqs.begin(), record->prereqs.end(), written))
+        return false;
+
+    // Without a depfile the headers are unknown, assume the worst
+    const std::vector<fs::path> *prereqs = state::prereqs(state, record, obj);
+    if (prereqs == nullptr) return true;
+
+    // Timestamps are coarse, a write in the same tick as the object may still be newer
+    const std::vector<fs::path> &headers = *prereqs;
+    bool touched = file::stat(src, graph->stats).mtime >= out.mtime;
+    for (const fs::path &header : headers) {
+        if (touched) break;
+        const FileStat &in = file::stat(header, graph->stats);
+        touched = !in.exists || in.mtime >= out.mtime;
+    }
+    if (!touched) return false;
+
+    // Something was touched, only the content decides
+    if (digest(headers, state, graph->memo) != record->content) return true;
+
+    file::touch(obj);
+    return false;
+}
+
+uint64_t build::digest(const std::vector<fs::path> &files, BuildState *state, HashMemo &memo) {
+    uint64_t sig = BRV_HASH_OFFSET;
+    for (const fs::path &file : files) {
+        sig = hash::string(file.string(), sig);
+        sig = hash::combine(sig, state::hash(state, file, memo));
+    }
+    return sig;
+}
+
+std::vector<fs::path> build::readDepfile(const fs::path &dep) {
+    std::ifstream file(dep);
+    BRV_ASSERT(file.is_open(), "Failed to open depfile ", dep, ".");
+
+    std::stringstream content;
+    content << file.rdbuf();
+    const std::string str = content.str();
+
+    // Make syntax : 'target: prereq prereq \' with escaped spaces and line continuations
+    std::vector<fs::path> prereqs{};
+    std::string token;
+    bool target = true;
+    for (size_t i = 0; i < str.size(); ++i) {
+        const char ch = str[i];
+
+        if (ch == '\\' && i + 1 < str.size()) {
+            const char next = str[i + 1];
+            if (next == '\n' || next == '\r') { ++i; continue; }
+            if (next == ' ' || next == '#' || next == '\\') { token += next; ++i; continue; }
+        }
+
+        if (target) {
+            if (ch == ':' && (i + 1 == str.size() || std::isspace((unsigned char)str[i + 1]) || str[i + 1] == '\\')) {
+                target = false;
+                token.clear();
+            }
+            continue;
+        }
+
+        if (std::isspace((unsigned char)ch)) {
+            if (!token.empty()) prereqs.emplace_back(token);
+            token.clear();
+            continue;
+        }
+        token += ch;
+    }
+    if (!token.empty()) prereqs.emplace_back(token);
+
+    return prereqs;
+}
+
+void build::sign(BuildGraph *graph, const CompileJob *job, const Process *proc) {
+    const ActionRecord *last = state::find(job->state, job->obj);
+
+    // Sign the fresh object against its new depfile, cache hits keep the usage of the last real compile
+    ActionRecord record{};
+    record.command = hash::argv(job->cmd);
+    const std::vector<fs::path> *prereqs = state::prereqs(job->state, &record, job->obj);
+    BRV_ASSERT(prereqs != nullptr, "Missing depfile of ", job->obj, ".");
+    record.content = digest(*prereqs, job->state, graph->memo);
+    record.peak_rss = proc != nullptr ? proc->peak_rss : last != nullptr ? last->peak_rss : 0;
+    record.cpu_ms = proc != nullptr ? proc->cpu_ms : last != nullptr ? last->cpu_ms : 0;
+    record.duration_ms = proc != nullptr
+        ? std::chrono::duration_cast<std::chrono::milliseconds>(proc->end - proc->start).count()
+        : last != nullptr ? last->duration_ms : 0;
+
+    state::record(job->state, job->obj, record);
+}
+
+uint64_t build::predict(BuildState *state, const fs::path &obj, uint64_t average) {
+    const ActionRecord *record = state::find(state, obj);
+    return record != nullptr && record->peak_rss != 0 ? record->peak_rss : average;
+}
+
+uint64_t build::estimate(BuildState *state, const fs::path &dst, uint64_t fallback) {
+    const ActionRecord *record = state::find(state, dst);
+    return record != nullptr && record->duration_ms != 0 ? record->duration_ms : fallback;
+}
+
+void build::report(const BuildGraph *graph) {
+    std::vector<std::pair<const CompileJob *, const ActionRecord *>> heaviest{};
+    for (const CompileJob &job : graph->jobs) {
+        const ActionRecord *record = state::find(job.state, job.obj);
+        if (record != nullptr && record->peak_rss != 0)
+            heaviest.emplace_back(&job, record);
+    }
+    if (heaviest.empty()) return;
+
+    std::sort(heaviest.begin(), heaviest.end(), [](const auto &a, const auto &b) {
+        return a.second->peak_rss > b.second->peak_rss;
+    });
+    if (heaviest.size() > BRV_PROC_HEAVIEST_COUNT)
+        heaviest.resize(BRV_PROC_HEAVIEST_COUNT);
+
+    std::ostringstream str;
+    str << "Heaviest translation units:";
+    for (const std::pair<const CompileJob *, const ActionRecord *> &pair : heaviest)
+        str << std::endl << "        " << std::setw(30) << std::left << pair.first->src.filename().string()
+            << std::setw(12) << std::to_string(pair.second->peak_rss / 1024) + " MiB"
+            << tests::seconds(pair.second->cpu_ms / 1000.0) << " cpu";
+    BRV_INFO(str.str());
 }
 
-bool build::rebuild(const fs::path &src, const fs::path &obj) {
-    if (!file::isfile(obj)) return true;
-    return fs::last_write_time(src) > fs::last_write_time(obj);
+uint64_t build::memoryBudget(const CmdContext *cctx) {
+    const std::optional<unsigned int> &memory = cctx->active_project->config->memory;
+    if (memory.has_value()) return (uint64_t)memory.value() * 1024;
+
+    // Leave some headroom for the rest of the system by default
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long page_size = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || page_size <= 0) return 0;
+    return (uint64_t)(pages / 1024 * page_size * BRV_PROC_MEMORY_RATIO);
+}
+
+bool build::selected(const CmdContext *cctx, const fs::path &test) {
+    const std::string name = test.stem().string();
+
+    if (!cctx->non_opt_args.empty()
+        && std::find(cctx->non_opt_args.begin(), cctx->non_opt_args.end(), name) == cctx->non_opt_args.end())
+        return false;
+
+    if (cctx->shard_count == 1) return true;
+
+    // Sources, objects and executables mirror 'tests/src', tests of the same name in other directories stay apart
+    const BuildContext *bctx = cctx->active_project->build;
+    const auto relative = [](const fs::path &path, const fs::path &dir, const std::string &ext) {
+        std::string rel = fs::absolute(path).lexically_normal().lexically_relative(fs::absolute(dir).lexically_normal()).string();
+        if (rel.ends_with(ext)) rel.resize(rel.size() - ext.size());
+        return rel;
+    };
+    std::string key = test.string();
+    for (const auto &[dir, ext] : {std::pair<fs::path, std::string>{bctx->test_dir / BRV_DIR_SRC, BRV_FILE_EXT_CPP},
+        {bctx->test_obj_dir, BRV_FILE_EXT_OBJ}, {bctx->test_bin_dir, BRV_FILE_EXT_EXE}}) {
+        const std::string rel = relative(test, dir, ext);
+        if (!rel.empty() && !rel.starts_with("..")) {
+            key = rel;
+            break;
+        }
+    }
+
+    // Round robin over the sorted test paths, stable across machines sharing a checkout
+    unsigned int rank = 0;
+    for (const fs::path &src : bctx->test_src_files)
+        if (relative(src, bctx->test_dir / BRV_DIR_SRC, BRV_FILE_EXT_CPP) < key)
+            ++rank;
+    return rank % cctx->shard_count == cctx->shard_index - 1;
 }
 
-int build::threadCount(const std::vector<std::string> &cmds) {
-    return std::min(std::thread::hardware_concurrency(), (unsigned int)cmds.size());
+unsigned int build::threadCount(const CmdContext *cctx) {
+    if (cctx->jobs != 0) return cctx->jobs;
+    if (cctx->active_project->config->jobs.has_value()) return cctx->active_project->config->jobs.value();
+    return std::max(std::thread::hardware_concurrency(), 1U);
 }
@@ -0,0 +1,201 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
+using namespace brv;
+
+CacheContext *cache::open(const std::string &compiler) {
+    const char *dir = std::getenv(BRV_ENV_CACHE_DIR);
+    if (dir == nullptr || *dir == '\0') return nullptr;
+
+    CacheContext *cache = new CacheContext();
+    cache->dir = fs::absolute(dir);
+    fs::create_directories(cache->dir);
+
+    const char *size = std::getenv(BRV_ENV_CACHE_SIZE);
+    cache->max_size = size == nullptr ? BRV_CACHE_DEFAULT_SIZE : parseSize(size);
+
+    // Objects from another compiler version must never be served
+    std::string version;
+    BRV_ASSERT(proc::capture({compiler, "--version"}, version) == EXIT_SUCCESS, "Failed to identify compiler '", compiler, "'.");
+
+    cache->compiler = hash::string(version);
+    return cache;
+}
+
+uint64_t cache::key(const CacheContext *cache, const CompileJob &job) {
+    const fs::path pre = fs::path(job.obj).replace_extension(BRV_FILE_EXT_PRE);
+    std::ifstream file(pre);
+    if (!file.is_open()) return 0;
+
+    // Include and module paths only steer preprocessing and differ per checkout, the expanded source covers them.
+    // Precompiled headers are expanded with '-include' and module units are never cached.
+    uint64_t key = hash::argv(job.flags, cache->compiler);
+
+    // Debug info names the source relative to its project, see build::commonFlags
+    const bool debug = std::any_of(job.flags.begin(), job.flags.end(), [](const std::string &flag) { return flag.starts_with("-g"); });
+    if (debug) key = hash::string(job.src.lexically_relative(job.root).string(), key);
+
+    // Skip line markers so identical code from other checkouts hashes the same.
+    // Debug info records their lines and paths, only the project root is mapped so dependency headers stay absolute.
+    const std::string root = "\"" + job.root.string() + "/";
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.size() > 2 && line[0] == '#' && line[1] == ' ' && std::isdigit((unsigned char)line[2])) {
+            if (!debug) continue;
+            const size_t at = line.find(root);
+            if (at != std::string::npos) line.replace(at + 1, root.size() - 2, ".");
+        }
+        key = hash::string(line, key);
+        key = hash::combine(key, '\n');
+    }
+    file.close();
+    fs::remove(pre);
+
+    return key;
+}
+
+bool cache::fetch(CacheContext *cache, uint64_t key, const fs::path &obj) {
+    const fs::path path = entry(cache, key);
+
+    std::error_code error;
+    if (!fs::is_regular_file(path, error)) {
+        ++cache->misses;
+        return false;
+    }
+
+    // Recency lives in a stamp next to the entry, the entry's own mtime is shared with every hardlinked object
+    const fs::path stamp = fs::path(path).replace_extension(BRV_CACHE_EXT_USED);
+    std::ofstream(stamp).close();
+    fs::last_write_time(stamp, fs::file_time_type::clock::now(), error);
+
+    restore(path, obj);
+    ++cache->hits;
+    return true;
+}
+
+void cache::store(CacheContext *cache, uint64_t key, const fs::path &obj) {
+    const fs::path path = entry(cache, key);
+
+    std::ostringstream suffix;
+    suffix << BRV_CACHE_TMP_MARKER << getpid() << "." << std::this_thread::get_id();
+    fs::path tmp = path;
+    tmp += suffix.str();
+
+    // Copy aside then rename so concurrent builds never read a partial object
+    std::error_code error;
+    fs::create_directories(path.parent_path(), error);
+    fs::copy_file(obj, tmp, fs::copy_options::overwrite_existing, error);
+    if (!error) fs::rename(tmp, path, error);
+    if (error) fs::remove(tmp, error);
+}
+
+void cache::restore(const fs::path &entry, const fs::path &obj) {
+    std::error_code error;
+    fs::remove(obj, error);
+
+    fs::create_hard_link(entry, obj, error);
+    if (!error) return;
+
+#if defined(__linux__)
+    int src = ::open(entry.c_str(), O_RDONLY);
+    int dst = ::open(obj.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    const bool cloned = src >= 0 && dst >= 0 && ioctl(dst, FICLONE, src) == 0;
+    if (src >= 0) close(src);
+    if (dst >= 0) close(dst);
+    if (cloned) return;
+#elif defined(__APPLE__)
+    fs::remove(obj, error);
+    if (clonefile(entry.c_str(), obj.c_str(), 0) == 0) return;
+#endif
+
+    fs::copy_file(entry, obj, fs::copy_options::overwrite_existing, error);
+    BRV_ASSERT(!error, "Failed to restore ", obj.filename(), " from cache.");
+}
+
+void cache::evict(const CacheContext *cache) {
+    std::vector<std::pair<fs::file_time_type, fs::path>> entries{};
+    uintmax_t total = 0;
+
+    // Walking the whole cache after every build costs more than the entries it would trim, once in a while is enough
+    std::error_code error;
+    const fs::path stamp = cache->dir / BRV_CACHE_EVICT_STAMP;
+    const fs::file_time_type now = fs::file_time_type::clock::now();
+    const fs::file_time_type last = fs::last_write_time(stamp, error);
+    if (!error && now - last < BRV_CACHE_EVICT_INTERVAL) return;
+    std::ofstream(stamp).close();
+    fs::last_write_time(stamp, now, error);
+
+    // Temporaries left by a store that died count too, once old enough no build can still be writing them
+    const fs::file_time_type stale = now - BRV_CACHE_TMP_MAX_AGE;
+    for (const fs::directory_entry &entry : fs::recursive_directory_iterator(cache->dir, error)) {
+        if (!entry.is_regular_file(error)) continue;
+        const bool tmp = entry.path().filename().string().find(BRV_CACHE_TMP_MARKER) != std::string::npos;
+        if (!tmp && entry.path().extension() != BRV_FILE_EXT_OBJ) continue;
+
+        fs::file_time_type time = entry.last_write_time(error);
+        if (tmp && time < stale) {
+            fs::remove(entry.path(), error);
+            continue;
+        }
+        total += entry.file_size(error);
+        if (tmp) continue;
+
+        // Entries fetched since they were stored carry their last use in a stamp
+        const fs::file_time_type used = fs::last_write_time(fs::path(entry.path()).replace_extension(BRV_CACHE_EXT_USED), error);
+        if (!error) time = std::max(time, used);
+        entries.emplace_back(time, entry.path());
+    }
+
+    if (total <= cache->max_size) return;
+
+    // Trim below the limit so the next few builds do not evict again
+    std::sort(entries.begin(), entries.end());
+    const uintmax_t target = cache->max_size * BRV_CACHE_EVICT_RATIO;
+    for (const std::pair<fs::file_time_type, fs::path> &entry : entries) {
+        if (total <= target) break;
+        const uintmax_t size = fs::file_size(entry.second, error);
+        fs::remove(fs::path(entry.second).replace_extension(BRV_CACHE_EXT_USED), error);
+        if (fs::remove(entry.second, error)) total -= size;
+    }
+}
+
+fs::path cache::entry(const CacheContext *cache, uint64_t key) {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key;
+    const std::string str = name.str();
+    return cache->dir / str.substr(0, 2) / (str + BRV_FILE_EXT_OBJ);
+}
+
+uintmax_t cache::parseSize(const std::string &str) {
+    size_t end = 0;
+    uintmax_t size = 0;
+    try {
+        size = std::stoull(str, &end);
+    } catch (const std::exception &) {
+        BRV_THROW("Invalid cache size '", str, "'.");
+    }
+
+    const std::string unit = str.substr(end);
+    if (unit.empty()) return size;
+    switch (std::toupper(unit.front())) {
+    case 'K': return size << 10;
+    case 'M': return size << 20;
+    case 'G': return size << 30;
+    }
+    BRV_THROW("Invalid cache size unit '", unit, "'.");
+    return 0; // Silence compiler
+}
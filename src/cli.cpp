@@ -1,27 +1,42 @@
 #include <bravo/bravo.hpp>
 
+#include <stdexcept>
 #include <vector>
 
 using namespace brv;
 
 CmdContext *brv::processCliArgs(int argc, char **argv) {
     CmdContext *cctx = new CmdContext();
+    cctx->argv.assign(argv, argv + argc);
 
     if (argc < 2) {
         cctx->cmd = CMD_MAP.at(BRV_CMD_HELP_STR);
+        cctx->cmd_name = BRV_CMD_HELP_STR;
         return cctx;
     }
 
     const std::string cmd = cli::fuzzyMatch(argv[1], CMD_VECTOR);
     cctx->cmd = CMD_MAP.at(cmd);
+    cctx->cmd_name = cmd;
 
-    for (int i = 2; i < argc; i++)
-        cli::parseArg(argv[i], cmd, cctx);
+    // Traced objects live in their own directories, see 'cmd::analyze'
+    cctx->time_trace = cmd == BRV_CMD_ANALYZE_STR;
+
+    // Profile guided builds only make sense on optimized code
+    if (cmd == BRV_CMD_PGO_STR) cctx->profile = BRV_PROFILE_RELEASE;
+
+    const std::vector<std::string> args(argv + 2, argv + argc);
+    for (size_t i = 0; i < args.size(); i++)
+        cli::parseArg(args, i, cmd, cctx);
 
     if (cctx->verbose) {
         BRV_INFO("Verbose logging enabled!");
         BRV_CONDITIONAL(cctx->rebuild, "Recursive dependency rebuild enabled!");
         BRV_CONDITIONAL(cctx->no_build, "Build skip enabled!");
+        BRV_CONDITIONAL(cctx->unity, "Unity build enabled!");
+        BRV_CONDITIONAL(cctx->jobs != 0, "Job count set to ", cctx->jobs, "!");
+        BRV_CONDITIONAL(cctx->load > 0, "Load average limit set to ", cctx->load, "!");
+        BRV_CONDITIONAL(cctx->shard_count > 1, "Running test shard ", cctx->shard_index, "/", cctx->shard_count, "!");
         for (const std::string &arg : cctx->non_opt_args)
             BRV_INFO("Non-option argument parsed : '", arg, "'!");
     }
@@ -32,7 +47,9 @@ CmdContext *brv::processCliArgs(int argc, char **argv) {
     return cctx;
 }
 
-void cli::parseArg(const std::string &input, const std::string &cmd, CmdContext *cctx) {
+void cli::parseArg(const std::vector<std::string> &args, size_t &index, const std::string &cmd, CmdContext *cctx) {
+    const std::string &input = args.at(index);
+
     if (input.size() < 2)
         BRV_THROW("Invalid argument : '", input, "' : too short!");
 
@@ -44,22 +61,47 @@ void cli::parseArg(const std::string &input, const std::string &cmd, CmdContext
     }
 
     if (input.starts_with("--")) {
+        const size_t equal = input.find('=');
         unsigned int opt_id = OPT_LONG_MAP.at(
             fuzzyMatch(
-                input.substr(2),
+                input.substr(2, equal == std::string::npos ? std::string::npos : equal - 2),
                 OPT_LONG_VECTOR)
         );
-        setOpt(cctx, cmd, opt_id);
+
+        std::optional<std::string> value{};
+        if (equal != std::string::npos)
+            value = input.substr(equal + 1);
+        else if (VALUED_OPT_IDS.contains(opt_id))
+            value = nextValue(args, index);
+
+        setOpt(cctx, cmd, opt_id, value);
         return;
     }
 
-    for (const char &ch : input.substr(1)) {
+    const std::string shorts = input.substr(1);
+    for (size_t i = 0; i < shorts.size(); ++i) {
+        const char ch = shorts[i];
         if (!OPT_SHORT_SET.contains(ch))
             BRV_THROW("Unkown shorthand argument : '", ch, "'!");
-        setOpt(cctx, cmd, OPT_SHORT_MAP.at(ch));
+
+        const unsigned int opt_id = OPT_SHORT_MAP.at(ch);
+        if (!VALUED_OPT_IDS.contains(opt_id)) {
+            setOpt(cctx, cmd, opt_id, {});
+            continue;
+        }
+
+        // The rest of the group or the next argument is the value : '-j8', '-j 8'
+        setOpt(cctx, cmd, opt_id, i + 1 < shorts.size() ? shorts.substr(i + 1) : nextValue(args, index));
+        return;
     }
 }
 
+std::string cli::nextValue(const std::vector<std::string> &args, size_t &index) {
+    if (index + 1 >= args.size())
+        BRV_THROW("Argument '", args.at(index), "' requires a value!");
+    return args.at(++index);
+}
+
 std::string cli::fuzzyMatch(const std::string &input, const std::vector<std::string> &valid) {
     std::vector<std::string> matches;
     for (const std::string& valid : valid)
@@ -76,9 +118,13 @@ std::string cli::fuzzyMatch(const std::string &input, const std::vector<std::str
     return ""; // Silence compiler
 }
 
-void cli::setOpt(CmdContext *cctx, const std::string &cmd, unsigned int opt_id) {
+void cli::setOpt(CmdContext *cctx, const std::string &cmd, unsigned int opt_id, const std::optional<std::string> &value) {
     if (!VALID_OPT_IDS.at(cmd).contains(opt_id))
         BRV_THROW("Command '", cmd, "' does not support specified arguments!");
+    if (value.has_value() != VALUED_OPT_IDS.contains(opt_id))
+        BRV_THROW("Invalid use of a value with argument '", OPT_LONG_VECTOR.at(opt_id), "'!");
+
+    size_t slash;
 
     switch (opt_id) {
     case BRV_OPT_VERBOSE_ID:
@@ -90,5 +136,55 @@ void cli::setOpt(CmdContext *cctx, const std::string &cmd, unsigned int opt_id)
     case BRV_OPT_NO_BUILD_ID:
         cctx->no_build = true;
         return;
+    case BRV_OPT_UNITY_ID:
+        cctx->unity = true;
+        return;
+    case BRV_OPT_PROFILE_ID:
+        cctx->profile = value.value();
+        config::validateProfileName(cctx->profile);
+        return;
+    case BRV_OPT_JOBS_ID:
+        cctx->jobs = parseUint(value.value(), BRV_OPT_JOBS_STR_LONG);
+        BRV_ASSERT(cctx->jobs > 0, "Job count must be at least 1!");
+        return;
+    case BRV_OPT_SHARD_ID:
+        slash = value.value().find('/');
+        BRV_ASSERT(slash != std::string::npos, "Shard must be specified as '<index>/<count>'!");
+        cctx->shard_index = parseUint(value.value().substr(0, slash), BRV_OPT_SHARD_STR_LONG);
+        cctx->shard_count = parseUint(value.value().substr(slash + 1), BRV_OPT_SHARD_STR_LONG);
+        BRV_ASSERT(cctx->shard_index >= 1 && cctx->shard_index <= cctx->shard_count, "Shard index must be between 1 and the shard count!");
+        return;
+    case BRV_OPT_TIMEOUT_ID:
+        cctx->timeout = parseUint(value.value(), BRV_OPT_TIMEOUT_STR_LONG);
+        return;
+    case BRV_OPT_LOAD_ID:
+        cctx->load = parseDouble(value.value(), BRV_OPT_LOAD_STR_LONG);
+        return;
+    case BRV_OPT_TRACE_ID:
+        BRV_ASSERT(!value.value().empty(), "Argument 'trace' expects a file path!");
+        cctx->trace = trace::open(fs::absolute(value.value()));
+        return;
     }
 }
+
+unsigned int cli::parseUint(const std::string &value, const std::string &opt) {
+    BRV_ASSERT(!value.empty() && value.find_first_not_of("0123456789") == std::string::npos, "Argument '", opt, "' expects a positive integer, got '", value, "'!");
+
+    // Digits only, so the sole failure left is a value too large for the option
+    unsigned long long number = ULLONG_MAX;
+    try {
+        number = std::stoull(value);
+    } catch (const std::out_of_range &) {}
+    BRV_ASSERT(number <= UINT_MAX, "Argument '", opt, "' must be at most ", UINT_MAX, ", got '", value, "'!");
+    return number;
+}
+
+double cli::parseDouble(const std::string &value, const std::string &opt) {
+    size_t end = 0;
+    double number = -1;
+    try {
+        number = std::stod(value, &end);
+    } catch (const std::exception &) {}
+    BRV_ASSERT(end == value.size() && number >= 0, "Argument '", opt, "' expects a positive number, got '", value, "'!");
+    return number;
+}
@@ -0,0 +1,19 @@
+#include <bravo/bravo.hpp>
+
+using namespace brv;
+
+void cmd::analyze(const CmdContext *cctx) {
+    // Traces change every command, a separate variant keeps the profile's objects and reruns incremental
+    pgo::stage(cctx, cctx->profile + BRV_ANALYZE_SUFFIX);
+    cmd::build(cctx);
+
+    AnalyzeReport report{};
+    for (const fs::path &path : analyze::collect(cctx))
+        analyze::read(&report, path);
+
+    BRV_ASSERT(report.units != 0, "No time traces found, is the compiler clang?");
+    BRV_CONDITIONAL(cctx->verbose, "Read ", report.units, " time trace(s), ", report.missing, " missing!");
+
+    analyze::print("Most expensive headers (total ms, count, average ms)", report.headers);
+    analyze::print("Most expensive instantiations (total ms, count, average ms)", report.instantiations);
+}
@@ -0,0 +1,53 @@
+#include <bravo/bravo.hpp>
+
+#include <cstdlib>
+
+using namespace brv;
+
+void cmd::bench(const CmdContext *cctx) {
+    BenchContext bench{};
+
+    // Results go to a stable path so runs of different versions can be compared, the current directory by default
+    const fs::path results = fs::absolute(cctx->non_opt_args.size() > 2 ? fs::path(cctx->non_opt_args.at(2)) : fs::path(BRV_FILE_NAME_BENCH));
+
+    // A fresh directory of our own for the tree, removing it afterwards can never touch user files
+    std::string dir = (fs::temp_directory_path() / (BRV_DIR_BENCH ".XXXXXX")).string();
+    BRV_ASSERT(mkdtemp(dir.data()) != nullptr, "Failed to create a benchmark directory in ", fs::temp_directory_path(), ".");
+    bench::claim(dir);
+    bench.root = fs::path(dir) / BRV_DIR_BENCH_TREE;
+    bench.jobs = cctx->jobs;
+    bench.load = cctx->load;
+    if (cctx->non_opt_args.size() > 0)
+        bench.files = cli::parseUint(cctx->non_opt_args.at(0), "files");
+    if (cctx->non_opt_args.size() > 1)
+        bench.projects = cli::parseUint(cctx->non_opt_args.at(1), "projects");
+    BRV_ASSERT(bench.files > 0 && bench.projects > 0, "Benchmark needs at least one file and one project!");
+
+    BRV_INFO("Generating ", bench.files, " file(s) in ", bench.projects + 1, " project(s) at ", bench.root, "!");
+    bench::measure(&bench, "generate", [&]() { bench::generate(&bench); });
+
+    // The first build compiles everything, every later run finds the tree up to date
+    CmdContext *cold = bench::load(&bench);
+    bench::measure(&bench, "cold_build", [&]() { cmd::build(cold); });
+    releaseContext(cold);
+
+    for (unsigned int run = 0; run < BRV_BENCH_RUNS; ++run) {
+        CmdContext *warm = bench::load(&bench);
+
+        // Planning alone, link checks run inside the link actions and are timed as part of 'noop_build'
+        bench::measure(&bench, "plan", [&]() {
+            BuildGraph graph{};
+            build::compile(warm, &graph);
+            build::link(warm, &graph);
+            BRV_ASSERT(graph.jobs.empty(), "Benchmark tree is not up to date after a full build.");
+        });
+        bench::measure(&bench, "noop_build", [&]() { cmd::build(warm); });
+        releaseContext(warm);
+        BRV_CONDITIONAL(cctx->verbose, "Benchmark run ", run + 1, "/", BRV_BENCH_RUNS, " done!");
+    }
+
+    fs::create_directories(results.parent_path());
+    bench::write(&bench, results);
+    bench::cleanup();
+    BRV_INFO("Benchmark results written to ", results, "!");
+}
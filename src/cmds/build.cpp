@@ -4,6 +4,17 @@ using namespace brv;
 
 void cmd::build(const CmdContext *cctx) {
     if (cctx->no_build) return;
-    build::compile(cctx);
-    build::link(cctx);
+
+    uint64_t start = trace::now(cctx->trace);
+    if (cctx->unity) build::unify(cctx);
+
+    BuildGraph graph{};
+    graph.changed = cctx->changed;
+    build::compile(cctx, &graph);
+    build::link(cctx, &graph);
+    trace::phase(cctx->trace, "plan", start);
+
+    start = trace::now(cctx->trace);
+    build::execute(cctx, &graph);
+    trace::phase(cctx->trace, "build", start);
 }
@@ -0,0 +1,29 @@
+#include <bravo/bravo.hpp>
+
+using namespace brv;
+
+void cmd::pgo(const CmdContext *cctx) {
+    const fs::path dir = cctx->active_project->config->root / BRV_DIR_OBJ / (cctx->profile + BRV_PGO_SUFFIX_OPTIMIZED);
+    const fs::path raw = cctx->active_project->config->root / BRV_DIR_OBJ / (cctx->profile + BRV_PGO_SUFFIX_INSTRUMENTED) / BRV_PGO_DIR_RAW;
+
+    CmdContext instrumented = *cctx;
+    instrumented.pgo_generate = raw;
+    pgo::stage(cctx, cctx->profile + BRV_PGO_SUFFIX_INSTRUMENTED);
+    BRV_INFO("Building instrumented '", cctx->profile, "' variant...");
+    cmd::build(&instrumented);
+
+    uint64_t start = trace::now(cctx->trace);
+    pgo::train(cctx, raw);
+    fs::create_directories(dir);
+    const fs::path profile = pgo::merge(raw, dir);
+    trace::phase(cctx->trace, "train", start);
+    BRV_CONDITIONAL(cctx->verbose, "Merged training profile into ", profile, "!");
+
+    CmdContext optimized = *cctx;
+    optimized.pgo_use = profile;
+    pgo::stage(cctx, cctx->profile + BRV_PGO_SUFFIX_OPTIMIZED);
+    BRV_INFO("Building optimized '", cctx->profile, "' variant...");
+    cmd::build(&optimized);
+
+    BRV_INFO("Profile guided build written to ", cctx->active_project->build->end_dst, "!");
+}
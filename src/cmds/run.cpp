@@ -3,7 +3,7 @@
 using namespace brv;
 
 void cmd::run(const CmdContext *cctx) {
-    cmd::build(cctx); // TODO : skip linking if possible
+    cmd::build(cctx);
 
     const ProjectContext *pctx = cctx->active_project;
 
@@ -11,8 +11,11 @@ void cmd::run(const CmdContext *cctx) {
 
     const fs::path rel = fs::relative(pctx->build->end_dst, pctx->config->root);
 
-    std::string args = pctx->config->run_args.has_value() ? pctx->config->run_args.value() : "";
+    Argv argv = {rel.string()};
+    if (pctx->config->run_args.has_value())
+        for (const std::string &arg : proc::split(pctx->config->run_args.value()))
+            argv.push_back(arg);
 
-    int exit_code = std::system((rel.string() + " " + args).c_str());
+    int exit_code = proc::run(argv);
     BRV_CONDITIONAL(cctx->verbose, "Program exited with code : ", exit_code);
 }
@@ -3,33 +3,64 @@
 using namespace brv;
 
 void cmd::test(const CmdContext *cctx) {
-    cmd::build(cctx); // TODO : skip linking if possible
+    cmd::build(cctx);
 
     const BuildContext *bctx = cctx->active_project->build;
 
     BRV_ASSERT(!bctx->test_exe_files.empty(), "No test files found!");
 
-    const std::vector<fs::path> *tests = &bctx->test_exe_files;
-
-    if (!cctx->non_opt_args.empty()) {
-        std::vector<fs::path> matching{};
-        bool found;
-        for (const std::string &arg : cctx->non_opt_args) {
-            found = false;
-            for (const fs::path &test : *tests)
-                if (test.stem().string() == arg) {
-                    matching.emplace_back(test);
-                    found = true;
-                    break;
-                }
-            BRV_ASSERT(found, "Could not find matching test to argument : '", arg, "'!");
-        }
-        tests = &matching;
+    for (const std::string &arg : cctx->non_opt_args) {
+        bool found = false;
+        for (const fs::path &test : bctx->test_exe_files)
+            if (test.stem().string() == arg) {
+                found = true;
+                break;
+            }
+        BRV_ASSERT(found, "Could not find matching test to argument : '", arg, "'!");
     }
 
-    for (const fs::path &test : *tests) {
-        int exit_code = std::system((test.string()).c_str());
-        lm::LogType type = exit_code == 0 ? lm::LogType::Debug : lm::LogType::Warning;
-        LOGGER.log(type, "Test ", test.filename(), " exited with code : ", exit_code);
+    std::vector<TestResult> results{};
+    for (const fs::path &test : bctx->test_exe_files)
+        if (build::selected(cctx, test))
+            results.emplace_back().exe = test;
+
+    if (results.empty()) {
+        BRV_INFO("No tests in shard ", cctx->shard_index, "/", cctx->shard_count, "!");
+        return;
     }
+
+    Executor exec{};
+    proc::configure(cctx, &exec);
+    BRV_CONDITIONAL(cctx->verbose, "Running ", results.size(), " test(s) with ", exec.jobs, " job(s):");
+
+    // Results are reported in test order as soon as every earlier test is done
+    size_t reported = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        Process *proc = new Process();
+        proc->argv = {results[i].exe.string()};
+        proc->name = results[i].exe.filename().string();
+        proc->category = "test";
+        proc->timeout = static_cast<uint64_t>(cctx->timeout) * 1000;
+        proc->on_exit = [&, i](Process *proc) {
+            TestResult &result = results[i];
+            result.done = true;
+            result.timed_out = proc->timed_out;
+            result.status = proc->status;
+            result.seconds = std::chrono::duration<double>(proc->end - proc->start).count();
+            result.output = std::move(proc->output);
+
+            while (reported < results.size() && results[reported].done)
+                tests::report(cctx, results[reported++]);
+        };
+        proc::submit(&exec, proc);
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    proc::loop(&exec);
+    tests::summary(results, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    unsigned int failed = 0;
+    for (const TestResult &result : results)
+        if (result.status != EXIT_SUCCESS) ++failed;
+    BRV_ASSERT(failed == 0, failed, " test(s) failed!");
 }
@@ -0,0 +1,46 @@
+#include <bravo/bravo.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+
+using namespace brv;
+
+void cmd::watch(const CmdContext *cctx) {
+    WatchContext wctx{};
+    watch::open(cctx, &wctx);
+    BRV_INFO("Watching '", cctx->active_project->config->project_name, "', serving builds on ", wctx.socket, "!");
+
+    watch::build(cctx, &wctx, -1);
+
+    while (true) {
+        const bool pending = wctx.dirty || wctx.moved || wctx.reload;
+
+        // Editors save in several steps, wait for the events to settle before building
+        pollfd fds[2] = {{wctx.listen, POLLIN, 0}, {wctx.notify, POLLIN, 0}};
+        const nfds_t count = wctx.notify >= 0 ? 2 : 1;
+        const int wait = pending ? BRV_WATCH_DEBOUNCE_MS : wctx.notify >= 0 ? -1 : BRV_WATCH_POLL_MS;
+
+        const int ready = poll(fds, count, wait);
+        if (ready < 0 && errno == EINTR) continue;
+        BRV_ASSERT(ready >= 0, "Failed to poll the watch daemon : ", std::strerror(errno), ".");
+
+        if (count > 1 && (fds[1].revents & POLLIN)) {
+            watch::changed(&wctx);
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            watch::serve(cctx, &wctx);
+            continue;
+        }
+        if (wctx.notify < 0 && watch::changed(&wctx)) continue;
+        if (!pending) continue;
+
+        if (wctx.reload || (wctx.moved && watch::stale(cctx)))
+            watch::restart(cctx, &wctx);
+
+        BRV_INFO("Change detected, rebuilding!");
+        watch::build(cctx, &wctx, -1);
+        wctx.dirty = wctx.moved = false;
+    }
+}
@@ -2,7 +2,7 @@
 
 using namespace brv;
 
-ConfigContext *brv::processConfigFile(const CmdContext *cctx, const fs::path &root) {
+ConfigContext *brv::processConfigFile(const CmdContext *cctx, const fs::path &root, jltt::JValue *json) {
     ConfigContext *cfg = new ConfigContext();
 
     if (cctx->cmd.skip_config)
@@ -10,42 +10,80 @@ ConfigContext *brv::processConfigFile(const CmdContext *cctx, const fs::path &ro
 
     cfg->root = root;
 
-    config::load(cfg);
+    config::load(cfg, json != nullptr ? json : config::read(root));
 
     config::validate(cfg, cctx);
 
     return cfg;
 }
 
-void config::load(ConfigContext *cfg) {
-    jltt::JValue *json;
-
-    json = read(cfg->root);
-
+void config::load(ConfigContext *cfg, jltt::JValue *json) {
     cfg->project_name = getString(json, BRV_KEY_PROJECT_NAME);
     cfg->project_type = getString(json, BRV_KEY_PROJECT_TYPE);
     cfg->entry = getOptString(json, BRV_KEY_ENTRY);
     cfg->deps = getPathVec(json, BRV_KEY_DEPS);
+    // Deps are relative to the project and known by their canonical path
+    for (fs::path &dep : cfg->deps)
+        dep = fs::weakly_canonical(dep.is_relative() ? cfg->root / dep : dep);
     cfg->build_name = getString(json, BRV_KEY_BUILD_NAME);
     cfg->run_args = getOptString(json, BRV_KEY_RUN_ARGS);
+    cfg->pch = getOptString(json, BRV_KEY_PCH);
+    cfg->pgo_train = getOptString(json, BRV_KEY_PGO_TRAIN);
+    cfg->linker = getOptString(json, BRV_KEY_LINKER);
+
+    const std::optional<double> jobs = getOptNumber(json, BRV_KEY_JOBS);
+    if (jobs.has_value()) {
+        BRV_ASSERT(jobs.value() >= 0 && jobs.value() == (unsigned int)jobs.value(), "Value '", BRV_KEY_JOBS, "' must be a positive integer" );
+        cfg->jobs = jobs.value();
+    }
+
+    const std::optional<double> memory = getOptNumber(json, BRV_KEY_MEMORY);
+    if (memory.has_value()) {
+        BRV_ASSERT(memory.value() >= 0 && memory.value() == (unsigned int)memory.value(), "Value '", BRV_KEY_MEMORY, "' must be a positive integer" );
+        cfg->memory = memory.value();
+    }
+
+    const std::optional<double> unity_batch = getOptNumber(json, BRV_KEY_UNITY_BATCH);
+    if (unity_batch.has_value()) {
+        BRV_ASSERT(unity_batch.value() >= 0 && unity_batch.value() == (unsigned int)unity_batch.value(), "Value '", BRV_KEY_UNITY_BATCH, "' must be a positive integer" );
+        cfg->unity_batch = unity_batch.value();
+    }
+    cfg->unity_exclude = getPathVec(json, BRV_KEY_UNITY_EXCLUDE);
+    cfg->unity_group = getOptString(json, BRV_KEY_UNITY_GROUP);
+    cfg->profiles = getProfiles(json, BRV_KEY_PROFILES);
 
     delete json;
 }
 
 jltt::JValue *config::read(const fs::path &root) {
+    std::string error;
+    jltt::JValue *json = parse(root, error);
+
+    BRV_ASSERT(json != nullptr, error);
+
+    return json;
+}
+
+jltt::JValue *config::parse(const fs::path &root, std::string &error) {
     fs::path file = root;
     file /= BRV_FILE_NAME_CONFIG;
 
-    BRV_ASSERT(file::isfile(file), "Project must contain a 'bravo.json' config file.");
+    // Nothing is logged here, dependency configs are parsed by worker threads
+    if (!file::isfile(file)) {
+        error = "Project " + file::quote(root.string()) + " must contain a 'bravo.json' config file.";
+        return nullptr;
+    }
 
     jltt::Parser *parser = new jltt::Parser(file);
 
-    BRV_ASSERT(parser->state() == jltt::STATE_OPEN, "Failed to open config file.");
-
-    parser->start();
+    if (parser->state() == jltt::STATE_OPEN)
+        parser->start();
 
-    BRV_ASSERT(parser->state() == jltt::STATE_SUCCESS, "Failed to parse config file.");
-    BRV_ASSERT(parser->root()->type == jltt::JType::OBJECT, "Invalid config file structure.");
+    if (parser->state() != jltt::STATE_SUCCESS || parser->root()->type != jltt::JType::OBJECT) {
+        error = "Failed to parse config file " + file::quote(file.string()) + ".";
+        delete parser;
+        return nullptr;
+    }
 
     jltt::JValue *json = parser->root();
 
@@ -71,6 +109,24 @@ std::optional<std::string> config::getOptString(jltt::JValue *json, const jltt::
     return *val->as<jltt::JString>();
 }
 
+std::optional<double> config::getOptNumber(jltt::JValue *json, const jltt::JString &key) {
+    jltt::JValue *val = json->at(key);
+
+    if (val == nullptr) return {};
+    BRV_ASSERT(val->is<jltt::JNumber>(), "Value '", key, "' must be of type 'number'" );
+
+    return *val->as<jltt::JNumber>();
+}
+
+std::optional<bool> config::getOptBool(jltt::JValue *json, const jltt::JString &key) {
+    jltt::JValue *val = json->at(key);
+
+    if (val == nullptr) return {};
+    BRV_ASSERT(val->is<jltt::JBool>(), "Value '", key, "' must be of type 'bool'" );
+
+    return *val->as<jltt::JBool>();
+}
+
 std::vector<fs::path> config::getPathVec(jltt::JValue *json, const jltt::JString &key) {
     jltt::JValue *val = json->at(key);
 
@@ -86,3 +142,47 @@ std::vector<fs::path> config::getPathVec(jltt::JValue *json, const jltt::JString
 
     return paths;
 }
+
+std::vector<std::string> config::getStringVec(jltt::JValue *json, const jltt::JString &key) {
+    jltt::JValue *val = json->at(key);
+
+    if (val == nullptr) return {};
+    BRV_ASSERT(val->is<jltt::JArray>(), "Value '", key, "' must be of type 'array'" );
+
+    std::vector<std::string> strs;
+    for (jltt::JValue *element: *val->as<jltt::JArray>()) {
+        BRV_ASSERT(element->is<jltt::JString>(), "Values of '", key, "' array must be of type 'string'" );
+
+        strs.push_back(*element->as<jltt::JString>());
+    }
+
+    return strs;
+}
+
+std::map<std::string, ProfileConfig> config::getProfiles(jltt::JValue *json, const jltt::JString &key) {
+    jltt::JValue *val = json->at(key);
+
+    if (val == nullptr) return {};
+    BRV_ASSERT(val->is<jltt::JObject>(), "Value '", key, "' must be of type 'object'" );
+
+    std::map<std::string, ProfileConfig> profiles;
+    for (const std::pair<const jltt::JString, jltt::JValue *> &pair : *val->as<jltt::JObject>()) {
+        BRV_ASSERT(pair.second->is<jltt::JObject>(), "Values of '", key, "' object must be of type 'object'" );
+
+        ProfileConfig &profile = profiles[pair.first];
+        profile.inherits = getOptString(pair.second, BRV_KEY_PROFILE_INHERITS);
+        profile.opt = getOptString(pair.second, BRV_KEY_PROFILE_OPT);
+        profile.march = getOptString(pair.second, BRV_KEY_PROFILE_MARCH);
+        profile.lto = getOptString(pair.second, BRV_KEY_PROFILE_LTO);
+        profile.linker = getOptString(pair.second, BRV_KEY_LINKER);
+        profile.debug = getOptBool(pair.second, BRV_KEY_PROFILE_DEBUG);
+        profile.gc_sections = getOptBool(pair.second, BRV_KEY_PROFILE_GC_SECTIONS);
+        profile.split_debug = getOptBool(pair.second, BRV_KEY_PROFILE_SPLIT_DEBUG);
+        profile.compress_debug = getOptBool(pair.second, BRV_KEY_PROFILE_COMPRESS_DEBUG);
+        profile.defines = getStringVec(pair.second, BRV_KEY_PROFILE_DEFINES);
+        profile.flags = getStringVec(pair.second, BRV_KEY_PROFILE_FLAGS);
+        profile.link_flags = getStringVec(pair.second, BRV_KEY_PROFILE_LINK_FLAGS);
+    }
+
+    return profiles;
+}
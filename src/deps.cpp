@@ -1,5 +1,9 @@
 #include <bravo/bravo.hpp>
 
+#include <algorithm>
+#include <map>
+#include <thread>
+
 using namespace brv;
 
 BuildContext *brv::processDeps(const ConfigContext *cfg, CmdContext *cctx) {
@@ -9,42 +13,66 @@ BuildContext *brv::processDeps(const ConfigContext *cfg, CmdContext *cctx) {
         return bctx;
     }
 
-    deps::scanProject(bctx, cfg);
+    deps::scanProject(bctx, cfg, cctx->profile);
 
     deps::scanDeps(cfg, cctx);
 
     return bctx;
 }
 
-void deps::scanProject(BuildContext *bctx, const ConfigContext *cfg) {
+void deps::scanProject(BuildContext *bctx, const ConfigContext *cfg, const std::string &profile) {
+    const std::string error = scanTree(bctx, cfg, profile);
+    BRV_ASSERT(error.empty(), error);
+}
+
+std::string deps::scanTree(BuildContext *bctx, const ConfigContext *cfg, const std::string &profile) {
     fs::path root = cfg->root;
 
-    bctx->bin_dir = root / BRV_DIR_BIN;
+    // Every profile builds into its own directories so switching never invalidates another
+    bctx->bin_dir = root / BRV_DIR_BIN / profile;
     bctx->include_dir = root / BRV_DIR_INCLUDE;
-    bctx->obj_dir = root / BRV_DIR_OBJ;
+    bctx->obj_dir = root / BRV_DIR_OBJ / profile;
     bctx->src_dir = root / BRV_DIR_SRC;
     bctx->test_dir = root / BRV_DIR_TEST;
+    bctx->test_obj_dir = bctx->test_dir / BRV_DIR_OBJ / profile;
+    bctx->test_bin_dir = bctx->test_dir / BRV_DIR_BIN / profile;
+    bctx->module_dir = bctx->obj_dir / BRV_DIR_MODULES;
 
-    BRV_ASSERT(file::isdir(bctx->src_dir), "Project must contain a 'src' directory.");
-    BRV_ASSERT(file::isdir(bctx->include_dir), "Project must contain a 'include' directory.");
+    bctx->state = new BuildState();
+    bctx->state->path = bctx->obj_dir / BRV_FILE_NAME_STATE;
+    state::load(bctx->state);
 
-    file::recurse(bctx->src_dir, bctx->src_files, BRV_FILE_EXT_CPP);
+    // Nothing is logged here, worker threads hand the problem back to the main thread
+    if (!file::isdir(bctx->src_dir)) return "Project " + file::quote(root.string()) + " must contain a 'src' directory.";
+    if (!file::isdir(bctx->include_dir)) return "Project " + file::quote(root.string()) + " must contain a 'include' directory.";
+
+    // Listings of unchanged directories come from the state, a single stat each
+    state::recurse(bctx->state, fs::absolute(bctx->src_dir), bctx->src_files, {BRV_FILE_EXT_CPP, BRV_FILE_EXT_MODULE});
     file::swap(bctx->src_files, bctx->obj_files, bctx->src_dir, bctx->obj_dir, BRV_FILE_EXT_OBJ);
 
+    // 'foo.cpp' and 'foo.cppm' would both compile to 'foo.o' and overwrite each other
+    std::map<fs::path, fs::path> owners{};
+    for (size_t i = 0; i < bctx->src_files.size(); ++i) {
+        const std::pair<std::map<fs::path, fs::path>::iterator, bool> owner = owners.emplace(bctx->obj_files.at(i), bctx->src_files.at(i));
+        if (!owner.second)
+            return "Sources " + file::quote(owner.first->second.string()) + " and " + file::quote(bctx->src_files.at(i).string())
+                + " both compile to " + file::quote(bctx->obj_files.at(i).string()) + ".";
+    }
+
     if (file::isdir(bctx->test_dir / BRV_DIR_SRC)) {
-        file::recurse(bctx->test_dir / BRV_DIR_SRC, bctx->test_src_files, BRV_FILE_EXT_CPP);
+        state::recurse(bctx->state, fs::absolute(bctx->test_dir / BRV_DIR_SRC), bctx->test_src_files, {BRV_FILE_EXT_CPP});
         file::swap(
             bctx->test_src_files,
             bctx->test_obj_files,
             bctx->test_dir / BRV_DIR_SRC,
-            bctx->test_dir / BRV_DIR_OBJ,
+            bctx->test_obj_dir,
             BRV_FILE_EXT_OBJ
         );
         file::swap(
             bctx->test_src_files,
             bctx->test_exe_files,
             bctx->test_dir / BRV_DIR_SRC,
-            bctx->test_dir / BRV_DIR_BIN,
+            bctx->test_bin_dir,
             BRV_FILE_EXT_EXE
         );
     }
@@ -53,26 +81,83 @@ void deps::scanProject(BuildContext *bctx, const ConfigContext *cfg) {
     std::string ext = cfg->project_type == BRV_PROJECT_TYPE_EXEC ? BRV_FILE_EXT_EXE : BRV_FILE_EXT_ARCHIVE;
 
     bctx->end_dst = bctx->bin_dir / (cfg->build_name + ext);
+
+    if (cfg->pch.has_value()) {
+        bctx->pch_src = bctx->include_dir / cfg->pch.value();
+        bctx->pch_dst = bctx->obj_dir / (cfg->pch.value() + BRV_FILE_EXT_PCH);
+    }
     bctx->include_dirs.emplace_back(bctx->include_dir);
+    return "";
 }
 
 void deps::scanDeps(const ConfigContext *cfg, CmdContext *cctx) {
-    for (const fs::path &dep : cfg->deps) {
-
-        bool skip = false;
-        for (const ProjectContext *pctx : cctx->projects)
-            if (dep == pctx->config->root) {
-                skip = true;
-                break;
-            }
-        if (skip) continue;
-
-        ProjectContext *pctx = new ProjectContext();
+    for (ProjectContext *pctx : cctx->projects)
+        if (pctx->config == cfg)
+            cctx->project_index.emplace(fs::weakly_canonical(cfg->root), pctx);
+
+    // Breadth-first, deps are canonical so each project is loaded once whatever path leads to it
+    std::vector<fs::path> frontier = cfg->deps;
+    while (!frontier.empty()) {
+        std::vector<ProjectContext *> level{};
+        std::vector<fs::path> roots{};
+        for (const fs::path &dep : frontier) {
+            if (cctx->project_index.contains(dep)) continue;
+
+            ProjectContext *pctx = new ProjectContext();
+            cctx->projects.emplace_back(pctx);
+            cctx->project_index.emplace(dep, pctx);
+            level.push_back(pctx);
+            roots.push_back(dep);
+        }
+
+        loadLevel(cctx, level, roots);
+
+        frontier.clear();
+        for (const ProjectContext *pctx : level)
+            frontier.insert(frontier.end(), pctx->config->deps.begin(), pctx->config->deps.end());
+    }
+}
 
-        cctx->projects.emplace_back(pctx);
+void deps::loadLevel(const CmdContext *cctx, const std::vector<ProjectContext *> &level, const std::vector<fs::path> &roots) {
+    // Configs are parsed concurrently, reading them validates through the logger so that happens once every thread joined
+    std::vector<jltt::JValue *> jsons(level.size(), nullptr);
+    parallel(roots, [&](size_t i) {
+        std::string error;
+        jsons.at(i) = config::parse(roots.at(i), error);
+        return error;
+    });
+    for (size_t i = 0; i < level.size(); ++i) {
+        level.at(i)->config = processConfigFile(cctx, roots.at(i), jsons.at(i));
+        level.at(i)->build = new BuildContext();
+    }
 
-        pctx->config = processConfigFile(cctx, dep);
+    parallel(roots, [&](size_t i) {
+        return scanTree(level.at(i)->build, level.at(i)->config, cctx->profile);
+    });
+}
 
-        pctx->build = processDeps(pctx->config, cctx);
-    }
+void deps::parallel(const std::vector<fs::path> &roots, const std::function<std::string(size_t)> &task) {
+    // Workers never log, each keeps the problem of its project until every thread joined
+    std::vector<std::string> errors(roots.size());
+    std::atomic<size_t> next = 0;
+    const std::function<void()> work = [&]() {
+        for (size_t i = next++; i < roots.size(); i = next++) {
+            try {
+                errors.at(i) = task(i);
+            } catch (const std::exception &e) {
+                errors.at(i) = "Failed to load project " + file::quote(roots.at(i).string()) + " : " + e.what();
+            }
+        }
+    };
+
+    const size_t count = std::min<size_t>(roots.size(), std::max(std::thread::hardware_concurrency(), 1U));
+    std::vector<std::thread> threads{};
+    for (size_t i = 1; i < count; ++i)
+        threads.emplace_back(work);
+    work();
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (const std::string &error : errors)
+        BRV_ASSERT(error.empty(), error);
 }
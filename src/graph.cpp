@@ -3,28 +3,27 @@
 using namespace brv;
 
 void brv::resolveProtocol(CmdContext *cctx) {
-    std::set<fs::path> visited{}, visiting{};
+    std::unordered_set<const ProjectContext *> visited{}, visiting{};
 
     for (ProjectContext *pctx : cctx->projects)
         graph::build(visited, visiting, cctx, pctx);
 }
 
-void graph::build(std::set<fs::path> &visited, std::set<fs::path> &visiting, CmdContext *cctx, ProjectContext *pctx) {
-    fs::path root = pctx->config->root;
+void graph::build(std::unordered_set<const ProjectContext *> &visited, std::unordered_set<const ProjectContext *> &visiting, CmdContext *cctx, ProjectContext *pctx) {
+    BRV_ASSERT(!visiting.contains(pctx), "Circular dependecy involving '", pctx->config->project_name, "'.");
+    if (visited.contains(pctx)) return;
 
-    BRV_ASSERT(!visiting.contains(root), "Circular dependecy involving '", pctx->config->project_name, "'.");
-    if (visited.contains(root)) return;
+    visiting.insert(pctx);
 
-    visiting.insert(root);
+    // Each edge is a single lookup, the whole protocol is linear in projects and deps
+    for (const fs::path &path : pctx->config->deps) {
+        const std::unordered_map<fs::path, ProjectContext *>::const_iterator it = cctx->project_index.find(path);
+        BRV_ASSERT(it != cctx->project_index.end(), "Unresolved dependency ", path, " of '", pctx->config->project_name, "'.");
+        graph::build(visited, visiting, cctx, it->second);
+        pctx->build->include_dirs.push_back(it->second->build->include_dir);
+    }
 
-    for (const fs::path &path : pctx->config->deps)
-        for (ProjectContext *dpctx : cctx->projects)
-            if (dpctx->config->root == path) {
-                graph::build(visited, visiting, cctx, dpctx);
-                pctx->build->include_dirs.push_back(dpctx->build->include_dir);
-            }
-
-    visiting.erase(root);
-    visited.insert(root);
+    visiting.erase(pctx);
+    visited.insert(pctx);
     cctx->build_protocol.emplace_back(pctx);
 }
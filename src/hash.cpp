@@ -0,0 +1,53 @@
+#include <bravo/bravo.hpp>
+
+#include <fstream>
+
+using namespace brv;
+
+// FNV-1a, fast and good enough for change detection
+uint64_t hash::bytes(const char *data, size_t size, uint64_t seed) {
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= BRV_HASH_PRIME;
+    }
+    return hash;
+}
+
+uint64_t hash::string(const std::string &str, uint64_t seed) {
+    return bytes(str.data(), str.size(), seed);
+}
+
+uint64_t hash::argv(const Argv &argv, uint64_t seed) {
+    // Each argument is prefixed by its length, {"-DA", "B"} and {"-DA B"} must differ
+    uint64_t hash = seed;
+    for (const std::string &arg : argv)
+        hash = string(arg, combine(hash, arg.size()));
+    return hash;
+}
+
+uint64_t hash::file(const fs::path &path, uint64_t seed) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return combine(seed, 0);
+
+    std::vector<char> buffer(BRV_HASH_CHUNK_SIZE);
+    uint64_t hash = seed;
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        hash = bytes(buffer.data(), file.gcount(), hash);
+    }
+    return hash;
+}
+
+uint64_t hash::combine(uint64_t seed, uint64_t value) {
+    return bytes(reinterpret_cast<const char *>(&value), sizeof(value), seed);
+}
+
+uint64_t hash::memoFile(const fs::path &path, HashMemo &memo) {
+    const HashMemo::const_iterator it = memo.find(path);
+    if (it != memo.end()) return it->second;
+
+    const uint64_t hash = file(path);
+    memo.emplace(path, hash);
+    return hash;
+}
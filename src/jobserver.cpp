@@ -0,0 +1,136 @@
+#include <bravo/bravo.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace brv;
+
+// Tokens of an outer pool, handed back on exit so a failed build does not leave the parent short of them
+static Jobserver *joined = nullptr;
+static std::string held;
+
+Jobserver *jobserver::connect(unsigned int jobs, bool verbose) {
+    static Jobserver *instance = nullptr;
+    if (instance != nullptr) return instance;
+
+    instance = new Jobserver();
+
+    const char *env = std::getenv(BRV_ENV_MAKEFLAGS);
+    const std::string flags = env == nullptr ? "" : env;
+
+    // Client : an outer make or bravo already owns the token pool
+    size_t pos = flags.find(BRV_JOBSERVER_AUTH);
+    if (pos == std::string::npos) pos = flags.find(BRV_JOBSERVER_FDS);
+    if (pos != std::string::npos) {
+        pos = flags.find('=', pos) + 1;
+        const std::string auth = flags.substr(pos, flags.find(' ', pos) - pos);
+
+        if (auth.starts_with(BRV_JOBSERVER_FIFO)) {
+            const std::string path = auth.substr(std::string(BRV_JOBSERVER_FIFO).size());
+            instance->read = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+            instance->write = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+            instance->nonblocking = true;
+        } else if (auth.find(',') != std::string::npos) {
+            instance->read = std::atoi(auth.c_str());
+            instance->write = std::atoi(auth.c_str() + auth.find(',') + 1);
+        }
+
+        // Make only passes the descriptors to recipes marked as recursive
+        if (instance->read < 0 || instance->write < 0 || fcntl(instance->read, F_GETFD) < 0 || fcntl(instance->write, F_GETFD) < 0) {
+            BRV_CONDITIONAL(verbose, "Ignoring unusable jobserver '", auth, "'!");
+            instance->read = instance->write = -1;
+            return instance;
+        }
+
+        if (!instance->nonblocking) reopen(instance);
+        joined = instance;
+        std::atexit(flush);
+
+        BRV_CONDITIONAL(verbose, "Joined jobserver '", auth, "'!");
+        return instance;
+    }
+
+    if (jobs <= 1) return instance;
+
+    // Server : hand out jobs - 1 tokens, the implicit one is ours
+    int fds[2];
+    BRV_ASSERT(pipe(fds) == 0, "Failed to create jobserver pipe.");
+    instance->read = fds[0];
+    instance->write = fds[1];
+    instance->owner = true;
+
+    const std::string tokens(jobs - 1, BRV_JOBSERVER_TOKEN);
+    BRV_ASSERT(::write(instance->write, tokens.data(), tokens.size()) == (ssize_t)tokens.size(), "Failed to fill jobserver pipe.");
+
+    const std::string auth = std::to_string(fds[0]) + "," + std::to_string(fds[1]);
+    const std::string exported = flags + " -j" + std::to_string(jobs) + " " + BRV_JOBSERVER_AUTH + "=" + auth;
+    setenv(BRV_ENV_MAKEFLAGS, exported.c_str(), 1);
+
+    reopen(instance);
+
+    BRV_CONDITIONAL(verbose, "Serving ", jobs, " job token(s) on '", auth, "'!");
+    return instance;
+}
+
+void jobserver::reopen(Jobserver *server) {
+    // A private non-blocking description so nobody else's pipe changes mode, the original stays open for children
+#if defined(__linux__)
+    const std::string path = "/proc/self/fd/" + std::to_string(server->read);
+    const int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd >= 0) {
+        server->read = fd;
+        server->nonblocking = true;
+    }
+#else
+    // No private reopen here, the flag is shared with the other clients who must already expect EAGAIN
+    const int fd = fcntl(server->read, F_DUPFD_CLOEXEC, 0);
+    if (fd >= 0 && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0) {
+        server->read = fd;
+        server->nonblocking = true;
+    } else if (fd >= 0) {
+        ::close(fd);
+    }
+#endif
+}
+
+bool jobserver::acquire(Executor *exec) {
+    const Jobserver *server = exec->jobserver;
+
+    // Blocking descriptor left when no non-blocking one could be made : another client may still win the race
+    if (!server->nonblocking) {
+        pollfd fd = {server->read, POLLIN, 0};
+        if (poll(&fd, 1, 0) <= 0) return false;
+    }
+
+    // EAGAIN means another client took the token first
+    char token;
+    const ssize_t size = ::read(server->read, &token, 1);
+    if (size != 1) return false;
+
+    exec->tokens += token;
+    held += token;
+    return true;
+}
+
+void jobserver::release(Executor *exec) {
+    if (exec->tokens.empty()) return;
+
+    const char token = exec->tokens.back();
+    exec->tokens.pop_back();
+    held.pop_back();
+
+    while (::write(exec->jobserver->write, &token, 1) < 0 && errno == EINTR);
+}
+
+void jobserver::flush() {
+    if (joined == nullptr) return;
+
+    while (!held.empty()) {
+        const char token = held.back();
+        held.pop_back();
+        while (::write(joined->write, &token, 1) < 0 && errno == EINTR);
+    }
+}
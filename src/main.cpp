@@ -1,23 +1,38 @@
 #include <bravo/bravo.hpp>
 
 int main(int argc, char** argv) {
-    brv::CmdContext *cctx = new brv::CmdContext();
-    brv::ProjectContext *pctx = new brv::ProjectContext();
-
     // Parse and validate command and options
-    cctx = brv::processCliArgs(argc, argv);
-
-    cctx->projects.emplace_back(pctx);
-    cctx->active_project = pctx;
-
-    // Load and validate the json config file
-    pctx->config = brv::processConfigFile(cctx, fs::current_path());
-
-    // Scan project and dependencies
-    pctx->build = brv::processDeps(pctx->config, cctx);
-
-    // Resolve dependency graph
-    brv::resolveProtocol(cctx);
+    brv::CmdContext *cctx = brv::processCliArgs(argc, argv);
+
+    // A running watch daemon already has everything loaded
+    if (brv::watch::forward(cctx))
+        return EXIT_SUCCESS;
+
+    // Unchanged configs skip parsing, validation and resolution altogether
+    uint64_t start = brv::trace::now(cctx->trace);
+    if (brv::snapshot::load(cctx, fs::current_path())) {
+        brv::trace::phase(cctx->trace, "snapshot", start);
+    } else {
+        brv::ProjectContext *pctx = new brv::ProjectContext();
+        cctx->projects.emplace_back(pctx);
+        cctx->active_project = pctx;
+
+        // Load and validate the json config file
+        pctx->config = brv::processConfigFile(cctx, fs::current_path());
+        brv::trace::phase(cctx->trace, "config", start);
+
+        // Scan project and dependencies
+        start = brv::trace::now(cctx->trace);
+        pctx->build = brv::processDeps(pctx->config, cctx);
+        brv::trace::phase(cctx->trace, "scan", start);
+
+        // Resolve dependency graph
+        start = brv::trace::now(cctx->trace);
+        brv::resolveProtocol(cctx);
+        brv::trace::phase(cctx->trace, "resolve", start);
+
+        brv::snapshot::save(cctx);
+    }
 
     // Execute the command
     brv::executeCommand(cctx);
@@ -0,0 +1,65 @@
+#include <bravo/bravo.hpp>
+
+#include <iomanip>
+#include <sstream>
+
+using namespace brv;
+
+void pgo::stage(const CmdContext *cctx, const std::string &variant) {
+    // Each stage builds into its own directories so a later cycle only recompiles what changed
+    for (ProjectContext *pctx : cctx->projects) {
+        BuildContext *bctx = new BuildContext();
+        deps::scanProject(bctx, pctx->config, variant);
+        bctx->include_dirs = pctx->build->include_dirs;
+
+        delete pctx->build->state;
+        delete pctx->build;
+        pctx->build = bctx;
+    }
+}
+
+void pgo::train(const CmdContext *cctx, const fs::path &raw) {
+    const ProjectContext *pctx = cctx->active_project;
+
+    // Profiles of an earlier run would be merged into this one
+    fs::remove_all(raw);
+    fs::create_directories(raw);
+
+    Argv argv{};
+    if (pctx->config->pgo_train.has_value()) {
+        argv = proc::split(pctx->config->pgo_train.value());
+    } else {
+        BRV_ASSERT(pctx->config->project_type == BRV_PROJECT_TYPE_EXEC, "Project of type '", pctx->config->project_type, "' needs a '", BRV_KEY_PGO_TRAIN, "' command.");
+        argv.push_back(fs::relative(pctx->build->end_dst, pctx->config->root).string());
+        if (pctx->config->run_args.has_value())
+            for (const std::string &arg : proc::split(pctx->config->run_args.value()))
+                argv.push_back(arg);
+    }
+
+    BRV_CONDITIONAL(cctx->verbose, "Training : ", proc::join(argv));
+    const int exit_code = proc::run(argv);
+    BRV_ASSERT(exit_code == 0, "Training run exited with code ", exit_code, ".");
+}
+
+fs::path pgo::merge(const fs::path &raw, const fs::path &dir) {
+    Argv argv = {BRV_PGO_PROFDATA, "merge", "-o", (dir / ("merged" BRV_FILE_EXT_PROFDATA ".tmp")).string()};
+    const size_t count = argv.size();
+    for (const fs::directory_entry &entry : fs::directory_iterator(raw))
+        if (entry.path().extension() == BRV_FILE_EXT_PROFRAW)
+            argv.push_back(entry.path().string());
+    BRV_ASSERT(argv.size() > count, "Training run left no profile in ", raw, ", is the compiler clang?");
+
+    const int exit_code = proc::run(argv);
+    BRV_ASSERT(exit_code == 0, BRV_PGO_PROFDATA, " exited with code ", exit_code, ".");
+
+    // Named after its content so only a different profile changes the compile commands
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash::file(argv.at(3)) << BRV_FILE_EXT_PROFDATA;
+    const fs::path dst = dir / name.str();
+
+    for (const fs::directory_entry &entry : fs::directory_iterator(dir))
+        if (entry.path().extension() == BRV_FILE_EXT_PROFDATA && entry.path() != dst)
+            fs::remove(entry.path());
+    fs::rename(argv.at(3), dst);
+    return dst;
+}
@@ -0,0 +1,387 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using namespace brv;
+
+// Termination signal caught while the executor runs, processes in their own group would not get it otherwise
+static volatile sig_atomic_t interrupted = 0;
+
+void proc::configure(const CmdContext *cctx, Executor *exec) {
+    exec->jobs = build::threadCount(cctx);
+    exec->load = cctx->load;
+    exec->memory_budget = build::memoryBudget(cctx);
+    exec->trace = cctx->trace;
+
+    Jobserver *server = jobserver::connect(exec->jobs, cctx->verbose);
+    if (server->read >= 0) exec->jobserver = server;
+}
+
+void proc::submit(Executor *exec, Process *proc, bool urgent) {
+    if (urgent) exec->queue.push_front(proc);
+    else exec->queue.push_back(proc);
+}
+
+void proc::loop(Executor *exec) {
+    struct sigaction action{}, previous[2]{};
+    action.sa_handler = interrupt;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &previous[0]);
+    sigaction(SIGTERM, &action, &previous[1]);
+
+    while (!exec->queue.empty() || !exec->running.empty()) {
+        if (interrupted != 0) terminate(exec);
+
+        while (!exec->failed && !exec->queue.empty() && exec->running.size() < exec->jobs) {
+            const std::deque<Process *>::iterator next = pick(exec);
+            if (next == exec->queue.end() || !admit(exec)) break;
+
+            Process *proc = *next;
+            exec->queue.erase(next);
+            exec->memory_used += proc->memory;
+            spawn(proc);
+            exec->running.push_back(proc);
+        }
+
+        // A failure drains what is running and drops the rest
+        if (exec->failed) {
+            for (Process *proc : exec->queue) delete proc;
+            exec->queue.clear();
+            if (exec->running.empty()) break;
+        }
+
+        bool finished = false;
+        for (size_t i = 0; i < exec->running.size();) {
+            Process *proc = exec->running[i];
+            expire(proc);
+            drain(proc);
+            reap(proc);
+
+            if (proc->out >= 0 || proc->pid > 0) {
+                ++i;
+                continue;
+            }
+
+            exec->running.erase(exec->running.begin() + i);
+            exec->memory_used -= proc->memory;
+
+            // The first job runs on the implicit token, every other one holds a jobserver token
+            while (!exec->tokens.empty() && exec->tokens.size() >= exec->running.size())
+                jobserver::release(exec);
+
+            trace::process(exec->trace, proc);
+            if (proc->on_exit) proc->on_exit(proc);
+            delete proc;
+            finished = true;
+        }
+        if (finished || exec->running.empty()) continue;
+
+        std::vector<pollfd> fds{};
+        bool polling = exec->throttled;
+
+        // Wake up as soon as another process hands a token back
+        if (exec->jobserver != nullptr && !exec->queue.empty() && !exec->failed && exec->running.size() < exec->jobs)
+            fds.push_back({exec->jobserver->read, POLLIN, 0});
+
+        for (const Process *proc : exec->running) {
+            if (proc->out >= 0) fds.push_back({proc->out, POLLIN, 0});
+            if (proc->pidfd >= 0) fds.push_back({proc->pidfd, POLLIN, 0});
+            else if (proc->pid > 0) polling = true;
+        }
+
+        // Without pidfds exits are only noticed by polling
+        const int wait = deadline(exec, exec->throttled ? BRV_PROC_LOAD_POLL_MS : polling ? BRV_PROC_POLL_MS : -1);
+        if (fds.empty()) usleep((wait < 0 ? BRV_PROC_POLL_MS : wait) * 1000);
+        else poll(fds.data(), fds.size(), wait);
+    }
+
+    sigaction(SIGINT, &previous[0], nullptr);
+    sigaction(SIGTERM, &previous[1], nullptr);
+}
+
+void proc::interrupt(int signal) {
+    interrupted = signal;
+}
+
+void proc::terminate(Executor *exec) {
+    const int signal = interrupted;
+
+    // Other processes share our group and already got the signal, own groups get it forwarded then a grace period
+    for (const Process *proc : exec->running)
+        if (proc->timeout > 0 && proc->pid > 0)
+            kill(-proc->pid, signal);
+
+    const std::chrono::steady_clock::time_point limit = std::chrono::steady_clock::now() + std::chrono::milliseconds(BRV_PROC_KILL_GRACE_MS);
+    for (Process *proc : exec->running) {
+        if (proc->timeout == 0 || proc->pid <= 0) continue;
+        while (waitpid(proc->pid, nullptr, WNOHANG) == 0 && std::chrono::steady_clock::now() < limit)
+            usleep(BRV_PROC_POLL_MS * 1000);
+        kill(-proc->pid, SIGKILL);
+    }
+
+    // Die from the signal itself so the caller sees the usual exit status, exit handlers do not run then
+    jobserver::flush();
+    std::signal(signal, SIG_DFL);
+    raise(signal);
+}
+
+std::deque<Process *>::iterator proc::pick(Executor *exec) {
+    // Highest priority first, anything fits on an idle machine even when it exceeds the budget on its own
+    const bool limited = !exec->running.empty() && exec->memory_budget != 0;
+
+    std::deque<Process *>::iterator best = exec->queue.end();
+    for (std::deque<Process *>::iterator it = exec->queue.begin(); it != exec->queue.end(); ++it) {
+        if (limited && exec->memory_used + (*it)->memory > exec->memory_budget) continue;
+        if (best == exec->queue.end() || (*it)->priority > (*best)->priority) best = it;
+    }
+    return best;
+}
+
+bool proc::admit(Executor *exec) {
+    exec->throttled = false;
+    if (exec->running.empty()) return true;
+
+    if (exec->load > 0) {
+        double load;
+        if (getloadavg(&load, 1) == 1 && load >= exec->load) {
+            exec->throttled = true;
+            return false;
+        }
+    }
+
+    return exec->jobserver == nullptr || jobserver::acquire(exec);
+}
+
+void proc::spawn(Process *proc) {
+    std::vector<char *> argv{};
+    for (const std::string &arg : proc->argv)
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+
+    // Processes that may be killed get their own group so their children die with them
+    posix_spawnattr_t attrs;
+    posix_spawnattr_init(&attrs);
+    if (proc->timeout > 0) {
+        posix_spawnattr_setflags(&attrs, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attrs, 0);
+    }
+
+    int pipes[2] = {-1, -1};
+    if (proc->capture) {
+        BRV_ASSERT(pipe(pipes) == 0, "Failed to create output pipe.");
+        fcntl(pipes[0], F_SETFD, FD_CLOEXEC);
+        fcntl(pipes[1], F_SETFD, FD_CLOEXEC);
+
+        // One pipe for both streams keeps diagnostics in order
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, pipes[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, pipes[1], STDERR_FILENO);
+    }
+
+    proc->start = std::chrono::steady_clock::now();
+    const int error = posix_spawnp(&proc->pid, argv.front(), &actions, &attrs, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attrs);
+
+    if (proc->capture) {
+        close(pipes[1]);
+        proc->out = pipes[0];
+    }
+
+    if (error != 0) {
+        proc->pid = -1;
+        proc->end = proc->start;
+        proc->status = BRV_PROC_SPAWN_FAILURE;
+        proc->output += "Failed to execute '" + proc->argv.front() + "' : " + std::strerror(error) + "\n";
+        return;
+    }
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    proc->pidfd = syscall(SYS_pidfd_open, proc->pid, 0);
+#endif
+}
+
+void proc::drain(Process *proc) {
+    if (proc->out < 0) return;
+
+    char buffer[BRV_PROC_BUFFER_SIZE];
+    while (true) {
+        pollfd fd = {proc->out, POLLIN, 0};
+        if (poll(&fd, 1, 0) <= 0) return;
+
+        const ssize_t size = read(proc->out, buffer, sizeof(buffer));
+        if (size > 0) {
+            proc->output.append(buffer, size);
+            continue;
+        }
+        if (size < 0 && errno == EINTR) continue;
+
+        close(proc->out);
+        proc->out = -1;
+        return;
+    }
+}
+
+void proc::reap(Process *proc) {
+    // Pidfds only tell the loop when to look, the child is collected with wait4 as waitid has no rusage.
+    // The loop sweeps every running process after a wakeup, exits are not dispatched per descriptor.
+    if (proc->pid <= 0) return;
+
+    if (proc->pidfd >= 0) {
+        pollfd fd = {proc->pidfd, POLLIN, 0};
+        if (poll(&fd, 1, 0) <= 0) return;
+    }
+
+    int status;
+    rusage usage{};
+    if (wait4(proc->pid, &status, WNOHANG, &usage) <= 0) return;
+
+    proc->status = WIFEXITED(status) ? WEXITSTATUS(status) : BRV_PROC_SIGNAL_BASE + WTERMSIG(status);
+    proc->pid = -1;
+
+#if defined(__APPLE__)
+    proc->peak_rss = usage.ru_maxrss / 1024;
+#else
+    proc->peak_rss = usage.ru_maxrss;
+#endif
+    proc->cpu_ms = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+    proc->end = std::chrono::steady_clock::now();
+
+    if (proc->pidfd >= 0) {
+        close(proc->pidfd);
+        proc->pidfd = -1;
+    }
+}
+
+void proc::expire(Process *proc) {
+    if (proc->timeout == 0 || proc->timed_out || proc->pid <= 0) return;
+    if (std::chrono::steady_clock::now() - proc->start < std::chrono::milliseconds(proc->timeout)) return;
+
+    kill(-proc->pid, SIGKILL);
+    proc->timed_out = true;
+}
+
+int proc::deadline(const Executor *exec, int wait) {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (const Process *proc : exec->running) {
+        if (proc->timeout == 0 || proc->timed_out || proc->pid <= 0) continue;
+
+        const std::chrono::milliseconds left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            proc->start + std::chrono::milliseconds(proc->timeout) - now
+        );
+        const int ms = std::clamp<int64_t>(left.count() + 1, 0, INT_MAX);
+        if (wait < 0 || ms < wait) wait = ms;
+    }
+    return wait;
+}
+
+int proc::run(const Argv &argv) {
+    Executor exec{};
+    int status = EXIT_FAILURE;
+
+    Process *proc = new Process();
+    proc->argv = argv;
+    proc->capture = false;
+    proc->on_exit = [&status](Process *proc) {
+        std::cerr << proc->output;
+        status = proc->status;
+    };
+
+    submit(&exec, proc);
+    loop(&exec);
+    return status;
+}
+
+int proc::capture(const Argv &argv, std::string &output) {
+    Executor exec{};
+    int status = EXIT_FAILURE;
+
+    Process *proc = new Process();
+    proc->argv = argv;
+    proc->on_exit = [&status, &output](Process *proc) {
+        output = proc->output;
+        status = proc->status;
+    };
+
+    submit(&exec, proc);
+    loop(&exec);
+    return status;
+}
+
+Argv proc::split(const std::string &str) {
+    Argv argv{};
+    std::string token;
+    bool quoted = false, pending = false;
+    char quote = '\0';
+
+    for (size_t i = 0; i < str.size(); ++i) {
+        const char ch = str[i];
+
+        if (quoted) {
+            if (ch == quote) quoted = false;
+            else if (ch == '\\' && quote == '"' && i + 1 < str.size()) token += str[++i];
+            else token += ch;
+            continue;
+        }
+
+        if (ch == '"' || ch == '\'') {
+            quoted = pending = true;
+            quote = ch;
+        } else if (ch == '\\' && i + 1 < str.size()) {
+            token += str[++i];
+            pending = true;
+        } else if (std::isspace((unsigned char)ch)) {
+            if (pending) argv.push_back(token);
+            token.clear();
+            pending = false;
+        } else {
+            token += ch;
+            pending = true;
+        }
+    }
+    BRV_ASSERT(!quoted, "Unterminated quote in '", str, "'.");
+    if (pending) argv.push_back(token);
+
+    return argv;
+}
+
+std::string proc::join(const Argv &argv) {
+    std::string str;
+    for (const std::string &arg : argv) {
+        if (!str.empty()) str += ' ';
+        str += arg;
+    }
+    return str;
+}
+
+fs::path proc::which(const std::string &name) {
+    const char *path = std::getenv("PATH");
+    if (path == nullptr) return {};
+
+    std::string dirs = path;
+    for (size_t start = 0, end; start <= dirs.size(); start = end + 1) {
+        end = dirs.find(':', start);
+        if (end == std::string::npos) end = dirs.size();
+        const fs::path exe = fs::path(dirs.substr(start, end - start)) / name;
+        if (end > start && access(exe.c_str(), X_OK) == 0) return fs::canonical(exe);
+    }
+    return {};
+}
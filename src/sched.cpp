@@ -0,0 +1,75 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+
+using namespace brv;
+
+Action *sched::add(BuildGraph *graph, const std::string &name, const std::function<void(Action *)> &start) {
+    Action &action = graph->actions.emplace_back();
+    action.name = name;
+    action.start = start;
+    return &action;
+}
+
+void sched::depend(Action *action, Action *dep) {
+    dep->dependents.push_back(action);
+    ++action->pending;
+}
+
+void sched::start(BuildGraph *graph, Action *action) {
+    BRV_UNUSED(graph);
+    action->started = std::chrono::steady_clock::now();
+    action->start(action);
+}
+
+void sched::complete(BuildGraph *graph, Action *action) {
+    action->done = true;
+    action->elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - action->started).count();
+
+    for (Action *dependent : action->dependents)
+        if (--dependent->pending == 0 && !graph->exec.failed)
+            start(graph, dependent);
+}
+
+double sched::priority(Action *action) {
+    if (action->priority >= 0) return action->priority;
+
+    // Longest predicted path from this action to the end of the build
+    double tail = 0;
+    for (Action *dependent : action->dependents)
+        tail = std::max(tail, priority(dependent));
+
+    action->priority = action->cost + tail;
+    return action->priority;
+}
+
+double sched::criticalPath(const BuildGraph *graph, bool actual) {
+    // Actions are planned after their dependencies, one forward pass is enough
+    std::unordered_map<const Action *, double> finish{};
+    double longest = 0;
+    for (const Action &action : graph->actions) {
+        if (actual && !action.done) continue;
+        const double end = finish[&action] + (actual ? action.elapsed : action.cost);
+        longest = std::max(longest, end);
+        for (const Action *dependent : action.dependents)
+            finish[dependent] = std::max(finish[dependent], end);
+    }
+    return longest;
+}
+
+void sched::run(BuildGraph *graph) {
+    for (Action &action : graph->actions)
+        priority(&action);
+
+    // Roots start right away, everything else is released by its last dependency
+    std::vector<Action *> roots{};
+    for (Action &action : graph->actions)
+        if (action.pending == 0)
+            roots.push_back(&action);
+
+    // Up to date actions complete on the spot and may release others before the scan is over
+    for (Action *action : roots)
+        start(graph, action);
+
+    proc::loop(&graph->exec);
+}
@@ -0,0 +1,254 @@
+#include <bravo/bravo.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace brv;
+
+bool snapshot::load(CmdContext *cctx, const fs::path &root) {
+    if (cctx->cmd.skip_config) return false;
+
+    std::ifstream file(path(root), std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::stringstream content;
+    content << file.rdbuf();
+    const std::string data = content.str();
+
+    SnapshotReader reader{&data};
+    if (getNumber(&reader) != BRV_SNAPSHOT_MAGIC || getNumber(&reader) != BRV_SNAPSHOT_VERSION) return false;
+
+    // Every config must still be the exact file the snapshot was taken from
+    std::vector<ConfigContext *> configs{};
+    std::vector<std::vector<fs::path>> includes{};
+    const uint64_t count = getNumber(&reader);
+    for (uint64_t i = 0; i < count && reader.valid; ++i) {
+        ConfigContext *cfg = configs.emplace_back(new ConfigContext());
+        cfg->root = getString(&reader);
+
+        const int64_t mtime = getNumber(&reader);
+        const uint64_t size = getNumber(&reader);
+        const FileStat st = file::stat(cfg->root / BRV_FILE_NAME_CONFIG);
+        reader.valid = reader.valid && st.exists && st.mtime == mtime && st.size == size;
+
+        cfg->project_name = getString(&reader);
+        cfg->project_type = getString(&reader);
+        cfg->build_name = getString(&reader);
+        for (std::optional<std::string> *value : {&cfg->entry, &cfg->run_args, &cfg->pch, &cfg->pgo_train, &cfg->linker, &cfg->unity_group}) {
+            const bool has = getNumber(&reader);
+            const std::string str = getString(&reader);
+            if (has) *value = str;
+        }
+        for (std::optional<unsigned int> *value : {&cfg->jobs, &cfg->memory, &cfg->unity_batch}) {
+            const bool has = getNumber(&reader);
+            const unsigned int number = getNumber(&reader);
+            if (has) *value = number;
+        }
+        cfg->unity_exclude = getPaths(&reader);
+        cfg->deps = getPaths(&reader);
+        cfg->profiles = getProfiles(&reader);
+        includes.push_back(getPaths(&reader));
+    }
+
+    // A corrupt count must not size the vector, every index takes a number of its own
+    const uint64_t steps = getNumber(&reader);
+    reader.valid = reader.valid && steps <= (data.size() - reader.pos) / sizeof(uint64_t);
+    std::vector<uint64_t> protocol(reader.valid ? steps : 0);
+    for (uint64_t &index : protocol) {
+        index = getNumber(&reader);
+        reader.valid = reader.valid && index < count;
+    }
+
+    if (!reader.valid || count == 0 || reader.pos != data.size() || configs.front()->root != fs::weakly_canonical(root)) {
+        for (ConfigContext *cfg : configs)
+            delete cfg;
+        return false;
+    }
+
+    // Unchanged configs may still point at paths that went away since, those must fail like a fresh load
+    std::vector<fs::path> roots{};
+    for (ConfigContext *cfg : configs) {
+        config::validate(cfg, cctx);
+        roots.push_back(cfg->root);
+    }
+
+    // Sources are still scanned, the state keeps that to a stat per directory
+    for (size_t i = 0; i < configs.size(); ++i) {
+        ProjectContext *pctx = new ProjectContext();
+        pctx->config = configs.at(i);
+        pctx->build = new BuildContext();
+        cctx->projects.push_back(pctx);
+        cctx->project_index.emplace(fs::weakly_canonical(pctx->config->root), pctx);
+    }
+    deps::parallel(roots, [&](size_t i) {
+        return deps::scanTree(cctx->projects.at(i)->build, configs.at(i), cctx->profile);
+    });
+    for (size_t i = 0; i < configs.size(); ++i)
+        cctx->projects.at(i)->build->include_dirs = includes.at(i);
+    cctx->active_project = cctx->projects.front();
+    for (const uint64_t index : protocol)
+        cctx->build_protocol.push_back(cctx->projects.at(index));
+
+    BRV_CONDITIONAL(cctx->verbose, "Loaded project graph of ", count, " project(s) from snapshot!");
+    return true;
+}
+
+void snapshot::save(const CmdContext *cctx) {
+    if (cctx->cmd.skip_config) return;
+
+    // A config written in the same tick as its stat could change unnoticed, wait for the next run
+    const int64_t racy = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch() - std::chrono::milliseconds(BRV_STATE_RACY_MS)).count();
+
+    std::string out{};
+    putNumber(out, BRV_SNAPSHOT_MAGIC);
+    putNumber(out, BRV_SNAPSHOT_VERSION);
+    putNumber(out, cctx->projects.size());
+
+    std::unordered_map<const ProjectContext *, uint64_t> indices{};
+    for (const ProjectContext *pctx : cctx->projects) {
+        const ConfigContext *cfg = pctx->config;
+        const FileStat st = file::stat(cfg->root / BRV_FILE_NAME_CONFIG);
+        if (st.mtime >= racy) return;
+
+        indices.emplace(pctx, indices.size());
+        putString(out, fs::weakly_canonical(cfg->root).string());
+        putNumber(out, st.mtime);
+        putNumber(out, st.size);
+        putString(out, cfg->project_name);
+        putString(out, cfg->project_type);
+        putString(out, cfg->build_name);
+        for (const std::optional<std::string> *value : {&cfg->entry, &cfg->run_args, &cfg->pch, &cfg->pgo_train, &cfg->linker, &cfg->unity_group}) {
+            putNumber(out, value->has_value());
+            putString(out, value->value_or(""));
+        }
+        for (const std::optional<unsigned int> *value : {&cfg->jobs, &cfg->memory, &cfg->unity_batch}) {
+            putNumber(out, value->has_value());
+            putNumber(out, value->value_or(0));
+        }
+        putPaths(out, cfg->unity_exclude);
+        putPaths(out, cfg->deps);
+        putProfiles(out, cfg->profiles);
+        putPaths(out, pctx->build->include_dirs);
+    }
+
+    putNumber(out, cctx->build_protocol.size());
+    for (const ProjectContext *pctx : cctx->build_protocol)
+        putNumber(out, indices.at(pctx));
+
+    // Write next to the target and rename so an interrupted run never leaves a truncated snapshot
+    const fs::path dst = path(cctx->active_project->config->root);
+    fs::path tmp = dst;
+    tmp += ".tmp";
+    fs::create_directories(dst.parent_path());
+
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+    BRV_ASSERT(file.is_open(), "Failed to write project graph snapshot ", dst, ".");
+    file.write(out.data(), out.size());
+    file.close();
+
+    fs::rename(tmp, dst);
+}
+
+fs::path snapshot::path(const fs::path &root) {
+    return root / BRV_DIR_OBJ / BRV_FILE_NAME_GRAPH;
+}
+
+void snapshot::putNumber(std::string &out, uint64_t value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void snapshot::putString(std::string &out, const std::string &str) {
+    putNumber(out, str.size());
+    out.append(str);
+}
+
+void snapshot::putPaths(std::string &out, const std::vector<fs::path> &paths) {
+    putNumber(out, paths.size());
+    for (const fs::path &path : paths)
+        putString(out, path.string());
+}
+
+void snapshot::putStrings(std::string &out, const std::vector<std::string> &strs) {
+    putNumber(out, strs.size());
+    for (const std::string &str : strs)
+        putString(out, str);
+}
+
+void snapshot::putProfiles(std::string &out, const std::map<std::string, ProfileConfig> &profiles) {
+    putNumber(out, profiles.size());
+    for (const std::pair<const std::string, ProfileConfig> &pair : profiles) {
+        const ProfileConfig &profile = pair.second;
+        putString(out, pair.first);
+        for (const std::optional<std::string> *value : {&profile.inherits, &profile.opt, &profile.march, &profile.lto, &profile.linker}) {
+            putNumber(out, value->has_value());
+            putString(out, value->value_or(""));
+        }
+        for (const std::optional<bool> *value : {&profile.debug, &profile.gc_sections, &profile.split_debug, &profile.compress_debug}) {
+            putNumber(out, value->has_value());
+            putNumber(out, value->value_or(false));
+        }
+        putStrings(out, profile.defines);
+        putStrings(out, profile.flags);
+        putStrings(out, profile.link_flags);
+    }
+}
+
+uint64_t snapshot::getNumber(SnapshotReader *reader) {
+    uint64_t value = 0;
+    reader->valid = reader->valid && reader->pos + sizeof(value) <= reader->data->size();
+    if (!reader->valid) return 0;
+
+    std::memcpy(&value, reader->data->data() + reader->pos, sizeof(value));
+    reader->pos += sizeof(value);
+    return value;
+}
+
+std::string snapshot::getString(SnapshotReader *reader) {
+    const uint64_t size = getNumber(reader);
+    reader->valid = reader->valid && size <= reader->data->size() - reader->pos;
+    if (!reader->valid) return "";
+
+    const std::string str = reader->data->substr(reader->pos, size);
+    reader->pos += size;
+    return str;
+}
+
+std::vector<fs::path> snapshot::getPaths(SnapshotReader *reader) {
+    std::vector<fs::path> paths{};
+    const uint64_t count = getNumber(reader);
+    for (uint64_t i = 0; i < count && reader->valid; ++i)
+        paths.emplace_back(getString(reader));
+    return paths;
+}
+
+std::vector<std::string> snapshot::getStrings(SnapshotReader *reader) {
+    std::vector<std::string> strs{};
+    const uint64_t count = getNumber(reader);
+    for (uint64_t i = 0; i < count && reader->valid; ++i)
+        strs.push_back(getString(reader));
+    return strs;
+}
+
+std::map<std::string, ProfileConfig> snapshot::getProfiles(SnapshotReader *reader) {
+    std::map<std::string, ProfileConfig> profiles{};
+    const uint64_t count = getNumber(reader);
+    for (uint64_t i = 0; i < count && reader->valid; ++i) {
+        ProfileConfig &profile = profiles[getString(reader)];
+        for (std::optional<std::string> *value : {&profile.inherits, &profile.opt, &profile.march, &profile.lto, &profile.linker}) {
+            const bool has = getNumber(reader);
+            const std::string str = getString(reader);
+            if (has) *value = str;
+        }
+        for (std::optional<bool> *value : {&profile.debug, &profile.gc_sections, &profile.split_debug, &profile.compress_debug}) {
+            const bool has = getNumber(reader);
+            const bool flag = getNumber(reader);
+            if (has) *value = flag;
+        }
+        profile.defines = getStrings(reader);
+        profile.flags = getStrings(reader);
+        profile.link_flags = getStrings(reader);
+    }
+    return profiles;
+}
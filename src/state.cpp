@@ -0,0 +1,266 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace brv;
+
+void state::load(BuildState *state) {
+    if (state->loaded) return;
+    state->loaded = true;
+
+    const int fd = ::open(state->path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(StateHeader)) {
+        ::close(fd);
+        return;
+    }
+    state->mtime = (int64_t)BRV_STAT_MTIME(st).tv_sec * 1000000000 + BRV_STAT_MTIME(st).tv_nsec;
+    const size_t size = st.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return;
+
+    const char *data = static_cast<const char *>(map);
+    const StateHeader *header = reinterpret_cast<const StateHeader *>(data);
+
+    // Any mismatch in the layout only costs a full rebuild
+    const size_t tables = sizeof(StateHeader) + header->dirs * sizeof(StateDir) + header->files * sizeof(StateFile)
+        + header->records * sizeof(StateRecord) + header->indices * sizeof(uint32_t);
+    if (header->magic != BRV_STATE_MAGIC || header->version != BRV_STATE_VERSION || tables + header->bytes != size
+        || header->bytes == 0 || data[size - 1] != '\0') {
+        munmap(map, size);
+        return;
+    }
+
+    const StateDir *dirs = reinterpret_cast<const StateDir *>(data + sizeof(StateHeader));
+    const StateFile *files = reinterpret_cast<const StateFile *>(dirs + header->dirs);
+    const StateRecord *records = reinterpret_cast<const StateRecord *>(files + header->files);
+    const uint32_t *indices = reinterpret_cast<const uint32_t *>(records + header->records);
+    const char *blob = reinterpret_cast<const char *>(indices + header->indices);
+
+    bool valid = true;
+    const auto str = [&](uint32_t offset) {
+        valid = valid && offset < header->bytes;
+        return std::string(valid ? blob + offset : "");
+    };
+    const auto range = [&](uint32_t first, uint32_t count) {
+        valid = valid && (uint64_t)first + count <= header->indices;
+        return valid ? indices + first : indices;
+    };
+
+    for (uint32_t i = 0; i < header->dirs && valid; ++i) {
+        DirRecord &dir = state->dirs[str(dirs[i].path)];
+        dir.mtime = dirs[i].mtime;
+        const uint32_t *names = range(dirs[i].first, dirs[i].files + dirs[i].dirs);
+        for (uint32_t j = 0; j < dirs[i].files && valid; ++j)
+            dir.files.push_back(str(names[j]));
+        for (uint32_t j = dirs[i].files; j < dirs[i].files + dirs[i].dirs && valid; ++j)
+            dir.dirs.push_back(str(names[j]));
+    }
+
+    for (uint32_t i = 0; i < header->files && valid; ++i)
+        state->files[str(files[i].path)] = {files[i].mtime, files[i].size, files[i].hash};
+
+    for (uint32_t i = 0; i < header->records && valid; ++i) {
+        ActionRecord &record = state->records[str(records[i].key)];
+        record.command = records[i].command;
+        record.content = records[i].content;
+        record.peak_rss = records[i].peak_rss;
+        record.cpu_ms = records[i].cpu_ms;
+        record.duration_ms = records[i].duration_ms;
+        record.depfile = records[i].depfile;
+        const uint32_t *prereqs = range(records[i].first, records[i].prereqs);
+        for (uint32_t j = 0; j < records[i].prereqs && valid; ++j)
+            record.prereqs.emplace_back(str(prereqs[j]));
+    }
+
+    munmap(map, size);
+    if (valid) return;
+
+    state->dirs.clear();
+    state->files.clear();
+    state->records.clear();
+}
+
+void state::save(BuildState *state) {
+    if (!state->dirty) return;
+
+    fs::create_directories(state->path.parent_path());
+
+    // Stats taken in the same tick as a later write cannot tell the two apart, keep them out
+    const int64_t racy = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch() - std::chrono::milliseconds(BRV_STATE_RACY_MS)).count();
+
+    std::string blob{};
+    std::unordered_map<std::string, uint32_t> offsets{};
+    std::vector<uint32_t> indices{};
+    std::vector<StateDir> dirs{};
+    std::vector<StateFile> files{};
+    std::vector<StateRecord> records{};
+
+    for (const std::pair<const std::string, DirRecord> &pair : state->dirs) {
+        if (!pair.second.seen) continue;
+        dirs.push_back({intern(blob, offsets, pair.first), (uint32_t)indices.size(),
+            (uint32_t)pair.second.files.size(), (uint32_t)pair.second.dirs.size(), pair.second.mtime < racy ? pair.second.mtime : 0});
+        for (const std::string &name : pair.second.files)
+            indices.push_back(intern(blob, offsets, name));
+        for (const std::string &name : pair.second.dirs)
+            indices.push_back(intern(blob, offsets, name));
+    }
+
+    for (const std::pair<const std::string, FileRecord> &pair : state->files)
+        if (pair.second.mtime < racy)
+            files.push_back({intern(blob, offsets, pair.first), 0, pair.second.mtime, pair.second.size, pair.second.hash});
+
+    for (const std::pair<const std::string, ActionRecord> &pair : state->records) {
+        const ActionRecord &record = pair.second;
+        records.push_back({intern(blob, offsets, pair.first), (uint32_t)indices.size(), (uint32_t)record.prereqs.size(), 0,
+            record.command, record.content, record.peak_rss, record.cpu_ms, record.duration_ms, record.depfile});
+        for (const fs::path &prereq : record.prereqs)
+            indices.push_back(intern(blob, offsets, prereq.string()));
+    }
+
+    StateHeader header{};
+    header.dirs = dirs.size();
+    header.files = files.size();
+    header.records = records.size();
+    header.indices = indices.size();
+    header.bytes = blob.size();
+
+    // Write next to the target and rename so an interrupted build never leaves a truncated state
+    fs::path tmp = state->path;
+    tmp += ".tmp";
+
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+    BRV_ASSERT(file.is_open(), "Failed to write build state ", state->path, ".");
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(dirs.data()), dirs.size() * sizeof(StateDir));
+    file.write(reinterpret_cast<const char *>(files.data()), files.size() * sizeof(StateFile));
+    file.write(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(StateRecord));
+    file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(uint32_t));
+    file.write(blob.data(), blob.size());
+    file.close();
+
+    fs::rename(tmp, state->path);
+    state->dirty = false;
+}
+
+void state::reload(BuildState *state) {
+    // Listings stay those of the last scan, records and hashes come from the last build
+    std::unordered_map<std::string, DirRecord> dirs = std::move(state->dirs);
+    state->records.clear();
+    state->files.clear();
+    state->loaded = false;
+    state->dirty = false;
+    load(state);
+    state->dirs = std::move(dirs);
+}
+
+ActionRecord *state::find(BuildState *state, const fs::path &key) {
+    std::unordered_map<std::string, ActionRecord>::iterator it = state->records.find(key.string());
+    return it == state->records.end() ? nullptr : &it->second;
+}
+
+void state::record(BuildState *state, const fs::path &key, const ActionRecord &record) {
+    state->records[key.string()] = record;
+    state->dirty = true;
+}
+
+uint64_t state::averageRss(const BuildState *state) {
+    uint64_t total = 0, count = 0;
+    // Only compiles, a link or a test run would skew the estimate of an unrecorded compile
+    for (const std::pair<const std::string, ActionRecord> &pair : state->records)
+        if (pair.second.peak_rss != 0 && pair.first.ends_with(BRV_FILE_EXT_OBJ)) {
+            total += pair.second.peak_rss;
+            ++count;
+        }
+    return count == 0 ? 0 : total / count;
+}
+
+uint64_t state::averageDuration(const BuildState *state) {
+    uint64_t total = 0, count = 0;
+    for (const std::pair<const std::string, ActionRecord> &pair : state->records)
+        if (pair.second.duration_ms != 0 && pair.first.ends_with(BRV_FILE_EXT_OBJ)) {
+            total += pair.second.duration_ms;
+            ++count;
+        }
+    return count == 0 ? BRV_SCHED_DEFAULT_COMPILE_MS : total / count;
+}
+
+void state::recurse(BuildState *state, const fs::path &dir, std::vector<fs::path> &files, const std::set<std::string> &exts) {
+    const FileStat st = file::stat(dir);
+    if (!st.dir) return;
+
+    // A directory only changes when an entry is added, removed or renamed, file edits keep its listing
+    DirRecord &record = state->dirs[dir.string()];
+    record.seen = true;
+    if (record.mtime != st.mtime || st.mtime == 0) {
+        record.mtime = st.mtime;
+        record.files.clear();
+        record.dirs.clear();
+        // Linked directories are not descended, a link back to a parent would never end
+        for (const fs::directory_entry &entry : fs::directory_iterator(dir)) {
+            if (entry.is_directory() && !entry.is_symlink()) record.dirs.push_back(entry.path().filename().string());
+            else if (entry.is_regular_file()) record.files.push_back(entry.path().filename().string());
+        }
+        std::sort(record.files.begin(), record.files.end());
+        std::sort(record.dirs.begin(), record.dirs.end());
+        state->dirty = true;
+    }
+
+    for (const std::string &name : record.files)
+        if (exts.contains(fs::path(name).extension().string()))
+            files.push_back(dir / name);
+    for (const std::string &name : record.dirs)
+        recurse(state, dir / name, files, exts);
+}
+
+const std::vector<fs::path> *state::prereqs(BuildState *state, ActionRecord *record, const fs::path &obj) {
+    const fs::path dep = fs::path(obj).replace_extension(BRV_FILE_EXT_DEP);
+    const FileStat st = file::stat(dep);
+    if (!st.exists) return nullptr;
+
+    // The depfile is only parsed again once the compiler rewrote it
+    if (record->depfile == 0 || record->depfile != st.mtime) {
+        record->prereqs = build::readDepfile(dep);
+        record->depfile = st.mtime;
+        state->dirty = true;
+    }
+    return &record->prereqs;
+}
+
+uint64_t state::hash(BuildState *state, const fs::path &path, HashMemo &memo) {
+    const HashMemo::const_iterator it = memo.find(path);
+    if (it != memo.end()) return it->second;
+
+    const FileStat st = file::stat(path);
+    if (!st.exists) return hash::memoFile(path, memo);
+
+    FileRecord &record = state->files[path.string()];
+    if (record.mtime == st.mtime && record.size == st.size && record.mtime != 0) {
+        memo.emplace(path, record.hash);
+        return record.hash;
+    }
+
+    record = {st.mtime, st.size, hash::memoFile(path, memo)};
+    state->dirty = true;
+    return record.hash;
+}
+
+uint32_t state::intern(std::string &blob, std::unordered_map<std::string, uint32_t> &offsets, const std::string &str) {
+    const std::unordered_map<std::string, uint32_t>::const_iterator it = offsets.find(str);
+    if (it != offsets.end()) return it->second;
+
+    const uint32_t offset = blob.size();
+    blob.append(str.c_str(), str.size() + 1);
+    offsets.emplace(str, offset);
+    return offset;
+}
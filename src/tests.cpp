@@ -0,0 +1,54 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace brv;
+
+void tests::report(const CmdContext *cctx, const TestResult &result) {
+    const std::string name = result.exe.filename().string();
+
+    if (result.status == EXIT_SUCCESS) {
+        BRV_DEBUG("Test '", name, "' passed (", seconds(result.seconds), ")");
+        BRV_CONDITIONAL(cctx->verbose && !result.output.empty(), result.output);
+        return;
+    }
+
+    // Output is only worth reading when something went wrong
+    std::cerr << result.output;
+    if (result.timed_out)
+        BRV_WARNING("Test '", name, "' timed out after ", seconds(result.seconds), "!");
+    else
+        BRV_WARNING("Test '", name, "' failed with code : ", result.status, " (", seconds(result.seconds), ")");
+}
+
+void tests::summary(const std::vector<TestResult> &results, double elapsed) {
+    unsigned int passed = 0;
+    std::vector<const TestResult *> slowest{};
+    for (const TestResult &result : results) {
+        if (result.status == EXIT_SUCCESS) ++passed;
+        slowest.push_back(&result);
+    }
+
+    std::sort(slowest.begin(), slowest.end(), [](const TestResult *a, const TestResult *b) {
+        return a->seconds > b->seconds;
+    });
+    if (slowest.size() > BRV_TEST_SLOWEST_COUNT)
+        slowest.resize(BRV_TEST_SLOWEST_COUNT);
+
+    std::ostringstream str;
+    str << passed << " passed, " << results.size() - passed << " failed, " << results.size() << " total in " << seconds(elapsed);
+    str << std::endl << "    Slowest:";
+    for (const TestResult *result : slowest)
+        str << std::endl << "        " << std::setw(30) << std::left << result->exe.filename().string() << seconds(result->seconds);
+
+    LOGGER.log(passed == results.size() ? lm::LogType::Info : lm::LogType::Warning, "Tests : ", str.str());
+}
+
+std::string tests::seconds(double seconds) {
+    std::ostringstream str;
+    str << std::fixed << std::setprecision(2) << seconds << "s";
+    return str.str();
+}
@@ -0,0 +1,89 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+using namespace brv;
+
+// Written on exit, failed builds are the ones worth looking at
+static Trace *active = nullptr;
+
+Trace *trace::open(const fs::path &path) {
+    Trace *trace = new Trace();
+    trace->path = path;
+    trace->origin = std::chrono::steady_clock::now();
+
+    active = trace;
+    std::atexit(flush);
+    return trace;
+}
+
+uint64_t trace::now(const Trace *trace) {
+    return micros(trace, std::chrono::steady_clock::now());
+}
+
+uint64_t trace::micros(const Trace *trace, std::chrono::steady_clock::time_point time) {
+    if (trace == nullptr || time < trace->origin) return 0;
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - trace->origin).count();
+}
+
+void trace::phase(Trace *trace, const std::string &name, uint64_t start) {
+    if (trace == nullptr) return;
+    trace->events.push_back({name, "phase", start, now(trace), false});
+}
+
+void trace::process(Trace *trace, const Process *proc) {
+    if (trace == nullptr) return;
+
+    const std::string name = proc->name.empty() ? proc->argv.front() : proc->name;
+    const std::string category = proc->category.empty() ? "process" : proc->category;
+    trace->events.push_back({name, category, micros(trace, proc->start), micros(trace, proc->end), true});
+}
+
+void trace::write(const Trace *trace) {
+    std::vector<const TraceEvent *> events{};
+    for (const TraceEvent &event : trace->events)
+        events.push_back(&event);
+    std::stable_sort(events.begin(), events.end(), [](const TraceEvent *a, const TraceEvent *b) {
+        return a->start < b->start;
+    });
+
+    std::ofstream file(trace->path, std::ios::trunc);
+    if (!file.is_open()) {
+        BRV_ERROR("Failed to write trace ", trace->path, ".");
+        return;
+    }
+
+    // Spans go to the first worker track free when they start, one track per busy slot
+    std::vector<uint64_t> tracks{};
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+    file << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << BRV_TRACE_PID << ", \"tid\": " << BRV_TRACE_MAIN_TID
+         << ", \"args\": {\"name\": \"bravo\"}}";
+
+    for (const TraceEvent *event : events) {
+        size_t tid = BRV_TRACE_MAIN_TID;
+        if (event->worker) {
+            size_t track = 0;
+            while (track < tracks.size() && tracks[track] > event->start) ++track;
+            if (track == tracks.size()) {
+                tracks.push_back(0);
+                file << "," << std::endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << BRV_TRACE_PID
+                     << ", \"tid\": " << track + 1 << ", \"args\": {\"name\": \"worker " << track + 1 << "\"}}";
+            }
+            tracks[track] = event->end;
+            tid = track + 1;
+        }
+
+        file << "," << std::endl << "{\"name\": " << file::quote(event->name) << ", \"cat\": " << file::quote(event->category)
+             << ", \"ph\": \"X\", \"ts\": " << event->start << ", \"dur\": " << event->end - event->start
+             << ", \"pid\": " << BRV_TRACE_PID << ", \"tid\": " << tid << "}";
+    }
+    file << std::endl << "]}" << std::endl;
+}
+
+void trace::flush() {
+    if (active == nullptr) return;
+    write(active);
+    BRV_INFO("Trace written to ", active->path, "!");
+}
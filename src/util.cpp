@@ -1,5 +1,9 @@
 #include <bravo/bravo.hpp>
+#include <fstream>
+#include <sstream>
 #include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 using namespace brv;
 
@@ -9,6 +13,7 @@ void brv::executeCommand(CmdContext *cctx) {
 
 void brv::releaseContext(CmdContext *cctx) {
     for (ProjectContext *pctx : cctx->projects) {
+        delete pctx->build->state;
         delete pctx->build;
         delete pctx->config;
         delete pctx;
@@ -17,11 +22,25 @@ void brv::releaseContext(CmdContext *cctx) {
 }
 
 bool file::isdir(const fs::path &dir) {
-    return (fs::exists(dir) && fs::is_directory(dir));
+    std::error_code error;
+    return fs::is_directory(fs::status(dir, error));
 }
 
 bool file::isfile(const fs::path &file) {
-    return (fs::exists(file) && fs::is_regular_file(file));
+    std::error_code error;
+    return fs::is_regular_file(fs::status(file, error));
+}
+
+FileStat file::stat(const fs::path &path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return {};
+    return {true, S_ISDIR(st.st_mode), (int64_t)BRV_STAT_MTIME(st).tv_sec * 1000000000 + BRV_STAT_MTIME(st).tv_nsec, (uint64_t)st.st_size};
+}
+
+const FileStat &file::stat(const fs::path &path, StatMemo &memo) {
+    const StatMemo::const_iterator it = memo.find(path);
+    if (it != memo.end()) return it->second;
+    return memo.emplace(path, stat(path)).first->second;
 }
 
 void file::recurse(const fs::path &dir, std::vector<fs::path> &files, const std::string &target_ext) {
@@ -35,8 +54,55 @@ void file::recurse(const fs::path &dir, std::vector<fs::path> &files, const std:
 }
 
 void file::swap(const std::vector<fs::path> &srcs, std::vector<fs::path> &dsts, const fs::path &src, const fs::path &dst, const std::string &ext) {
+    // Sources are absolute and normal, a lexical relative path avoids resolving every one of them
+    const fs::path base = fs::absolute(src).lexically_normal();
     for (const fs::path &file : srcs) {
-        fs::path end = fs::relative(file, src).replace_extension(ext);
+        fs::path end = file.lexically_normal().lexically_relative(base).replace_extension(ext);
         dsts.emplace_back(dst / end);
     }
 }
+
+void file::touch(const fs::path &path) {
+    // Outputs restored from the cache may be hardlinks, their mtime is shared with the entry and every other checkout
+    struct stat st{};
+    if (::stat(path.c_str(), &st) == 0 && st.st_nlink > 1) {
+        fs::path tmp = path;
+        tmp += ".tmp";
+
+        std::error_code error;
+        fs::copy_file(path, tmp, fs::copy_options::overwrite_existing, error);
+        if (!error) fs::rename(tmp, path, error);
+        if (error) {
+            fs::remove(tmp, error);
+            return;
+        }
+    }
+
+    // The kernel clock lags behind the precise one, a later edit must never look older
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+}
+
+bool file::update(const fs::path &path, const std::string &content) {
+    // Rewriting identical content would only bump the mtime
+    std::ifstream old(path);
+    if (old.is_open()) {
+        std::stringstream current;
+        current << old.rdbuf();
+        if (current.str() == content) return false;
+    }
+
+    fs::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::trunc);
+    BRV_ASSERT(file.is_open(), "Failed to write ", path, ".");
+    file << content;
+    return true;
+}
+
+std::string file::quote(const std::string &str) {
+    std::string quoted = "\"";
+    for (const char ch : str) {
+        if (ch == '"' || ch == '\\') quoted += '\\';
+        quoted += ch;
+    }
+    return quoted + "\"";
+}
@@ -28,3 +28,70 @@ void config::validateDeps(const ConfigContext *cfg) {
     for (const fs::path &dep : cfg->deps)
         BRV_ASSERT(file::isdir(fs::absolute(dep)), "Dependecy paths must be valid and contain a 'bravo.json' config file.");
 }
+
+void config::validateJobs(const ConfigContext *cfg) {
+    if (cfg->jobs.has_value())
+        BRV_ASSERT(cfg->jobs.value() > 0, "Value 'jobs' must be at least 1.");
+}
+
+void config::validateMemory(const ConfigContext *cfg) {
+    if (cfg->memory.has_value())
+        BRV_ASSERT(cfg->memory.value() > 0, "Value 'memory' must be at least 1 (MiB).");
+}
+
+void config::validatePch(const ConfigContext *cfg) {
+    if (cfg->pch.has_value())
+        BRV_ASSERT(file::isfile(cfg->root / BRV_DIR_INCLUDE / cfg->pch.value()), "Value 'pch' must name a header in the 'include' directory.");
+}
+
+void config::validateUnity(const ConfigContext *cfg) {
+    if (cfg->unity_batch.has_value())
+        BRV_ASSERT(cfg->unity_batch.value() > 0, "Value 'unity_batch' must be at least 1.");
+    if (cfg->unity_group.has_value())
+        BRV_ASSERT(cfg->unity_group.value() == BRV_UNITY_GROUP_DIRECTORY || cfg->unity_group.value() == BRV_UNITY_GROUP_SIZE,
+            "Value 'unity_group' must be either 'directory' or 'size'.");
+    for (const fs::path &path : cfg->unity_exclude)
+        BRV_ASSERT(file::isfile(cfg->root / BRV_DIR_SRC / path), "Values of 'unity_exclude' must name source files in the 'src' directory.");
+}
+
+void config::validateProfiles(const ConfigContext *cfg) {
+    for (const std::pair<const std::string, ProfileConfig> &pair : cfg->profiles) {
+        validateProfileName(pair.first);
+        if (pair.second.inherits.has_value())
+            BRV_ASSERT(cfg->profiles.contains(pair.second.inherits.value()) || PROFILE_MAP.contains(pair.second.inherits.value()),
+                "Profile '", pair.first, "' inherits unknown profile '", pair.second.inherits.value(), "'.");
+        if (pair.second.opt.has_value())
+            BRV_ASSERT(VALID_PROFILE_OPTS.contains(pair.second.opt.value()), "Value 'opt' of profile '", pair.first, "' must be one of 0, 1, 2, 3, s, z, g or fast.");
+        if (pair.second.lto.has_value())
+            BRV_ASSERT(VALID_LTO_MODES.contains(pair.second.lto.value()), "Value 'lto' of profile '", pair.first, "' must be one of off, full or thin.");
+    }
+
+    // Inheritance cycles are only found by walking them
+    for (const std::pair<const std::string, ProfileConfig> &pair : cfg->profiles) {
+        std::set<std::string> visited{};
+        build::resolveProfile(cfg, pair.first, visited);
+    }
+}
+
+void config::validateProfileName(const std::string &name) {
+    // The name becomes a directory under obj/ and bin/, it must not climb out of them
+    BRV_ASSERT(!name.empty() && name.find('/') == std::string::npos && name.front() != '.',
+        "Profile names must be non-empty and usable as a directory name.");
+}
+
+void config::validateLinker(const ConfigContext *cfg) {
+    if (cfg->linker.has_value())
+        BRV_ASSERT(VALID_LINKERS.contains(cfg->linker.value()), "Value 'linker' must be one of system, lld or mold.");
+    for (const std::pair<const std::string, ProfileConfig> &pair : cfg->profiles)
+        if (pair.second.linker.has_value())
+            BRV_ASSERT(VALID_LINKERS.contains(pair.second.linker.value()), "Value 'linker' of profile '", pair.first, "' must be one of system, lld or mold.");
+
+    // The thin LTO cache is passed in the flags of a single linker, any other one fails the link
+    for (const std::pair<const std::string, ProfileConfig> &pair : cfg->profiles) {
+        std::set<std::string> visited{};
+        const ProfileConfig profile = build::resolveProfile(cfg, pair.first, visited);
+        if (profile.lto != BRV_LTO_THIN) continue;
+        const std::string name = profile.linker.value_or(cfg->linker.value_or(BRV_LTO_THIN_LINKER));
+        BRV_ASSERT(VALID_LTO_THIN_LINKERS.contains(name), "Thin LTO of profile '", pair.first, "' is not supported with linker '", name, "'.");
+    }
+}
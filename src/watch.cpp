@@ -0,0 +1,415 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+using namespace brv;
+
+bool watch::forward(const CmdContext *cctx) {
+    // Traces are written by the process running the build, the client would be left with an empty one
+    if (cctx->cmd_name != BRV_CMD_BUILD_STR || cctx->rebuild || cctx->no_build || cctx->trace != nullptr) return false;
+
+    const fs::path path = socket(fs::current_path(), cctx->profile);
+    if (!fs::exists(path)) return false;
+
+    // A socket nobody listens on is left over from a killed daemon
+    const int fd = dial(path);
+    if (fd < 0) return false;
+
+    std::ostringstream line;
+    line << BRV_CMD_BUILD_STR << " " << cctx->verbose << " " << cctx->jobs << " " << cctx->load << " " << cctx->unity << "\n";
+    const std::string request = line.str();
+    if (write(fd, request.data(), request.size()) != (ssize_t)request.size()) {
+        ::close(fd);
+        return false;
+    }
+
+    // The daemon relays the build output as is, its exit status follows a null byte
+    std::string status;
+    bool trailer = false;
+    char buffer[BRV_PROC_BUFFER_SIZE];
+    while (true) {
+        const ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR) continue;
+        if (size <= 0) break;
+
+        if (trailer) {
+            status.append(buffer, size);
+            continue;
+        }
+        const char *end = (const char *)std::memchr(buffer, '\0', size);
+        if (end == nullptr) {
+            std::cerr.write(buffer, size);
+            continue;
+        }
+        std::cerr.write(buffer, end - buffer);
+        status.append(end + 1, buffer + size - end - 1);
+        trailer = true;
+    }
+    ::close(fd);
+
+    if (!trailer || status.empty()) {
+        BRV_WARNING("Lost the watch daemon, building locally.");
+        return false;
+    }
+
+    int code = 0;
+    const std::from_chars_result result = std::from_chars(status.data(), status.data() + status.size(), code);
+    if (result.ec != std::errc() || result.ptr != status.data() + status.size()) {
+        BRV_WARNING("Malformed reply from the watch daemon, building locally.");
+        return false;
+    }
+    if (code == BRV_WATCH_FALLBACK) return false;
+
+    BRV_CONDITIONAL(cctx->verbose, "Build served by the watch daemon on ", path, "!");
+    if (code != EXIT_SUCCESS) std::exit(code);
+    return true;
+}
+
+int watch::dial(const fs::path &path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.string().size() >= sizeof(addr.sun_path)) return -1;
+    std::strcpy(addr.sun_path, path.c_str());
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    if (connect(fd, (const sockaddr *)&addr, sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void watch::open(const CmdContext *cctx, WatchContext *wctx) {
+    wctx->socket = socket(cctx->active_project->config->root, cctx->profile);
+    fs::create_directories(wctx->socket.parent_path());
+
+    const int other = dial(wctx->socket);
+    if (other >= 0) ::close(other);
+    BRV_ASSERT(other < 0, "A watch daemon is already running on ", wctx->socket, ".");
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    BRV_ASSERT(wctx->socket.string().size() < sizeof(addr.sun_path), "Socket path ", wctx->socket, " is too long.");
+    std::strcpy(addr.sun_path, wctx->socket.c_str());
+
+    fs::remove(wctx->socket);
+    wctx->listen = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    BRV_ASSERT(wctx->listen >= 0, "Failed to create the watch socket : ", std::strerror(errno), ".");
+    fcntl(wctx->listen, F_SETFD, FD_CLOEXEC);
+    BRV_ASSERT(bind(wctx->listen, (const sockaddr *)&addr, sizeof(addr)) == 0,
+        "Failed to bind ", wctx->socket, " : ", std::strerror(errno), ".");
+    BRV_ASSERT(::listen(wctx->listen, BRV_WATCH_BACKLOG) == 0, "Failed to listen on ", wctx->socket, ".");
+
+    // Clients that hang up mid-build must not take the daemon with them
+    signal(SIGPIPE, SIG_IGN);
+
+#ifdef __linux__
+    wctx->notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    BRV_ASSERT(wctx->notify >= 0, "Failed to initialize inotify : ", std::strerror(errno), ".");
+#endif
+
+    // Only inputs are watched, outputs written by the builds would retrigger them
+    for (const ProjectContext *pctx : cctx->build_protocol) {
+        wctx->roots.insert(pctx->config->root);
+        add(wctx, pctx->config->root, false);
+        for (const fs::path &dir : inputs(pctx))
+            add(wctx, dir, true);
+    }
+
+    if (wctx->notify < 0)
+        wctx->files = snapshot(wctx);
+}
+
+void watch::close(WatchContext *wctx) {
+    if (wctx->notify >= 0) ::close(wctx->notify);
+    if (wctx->listen >= 0) ::close(wctx->listen);
+    wctx->notify = wctx->listen = -1;
+    fs::remove(wctx->socket);
+}
+
+void watch::add(WatchContext *wctx, const fs::path &dir, bool recursive) {
+#ifdef __linux__
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+    const int wd = inotify_add_watch(wctx->notify, dir.c_str(), mask);
+    if (wd < 0) {
+        BRV_WARNING("Failed to watch ", dir, " : ", std::strerror(errno), ".");
+        return;
+    }
+    wctx->dirs[wd] = dir;
+#else
+    // Snapshots walk the trees themselves
+    wctx->dirs[wctx->dirs.size()] = dir;
+    BRV_UNUSED(recursive);
+    return;
+#endif
+
+    if (!recursive) return;
+    for (const fs::directory_entry &entry : fs::directory_iterator(dir))
+        if (entry.is_directory() && !entry.is_symlink())
+            add(wctx, entry.path(), true);
+}
+
+std::vector<fs::path> watch::inputs(const ProjectContext *pctx) {
+    std::vector<fs::path> dirs = {pctx->build->src_dir, pctx->build->include_dir};
+    if (file::isdir(pctx->build->test_dir / BRV_DIR_SRC))
+        dirs.push_back(pctx->build->test_dir / BRV_DIR_SRC);
+    return dirs;
+}
+
+bool watch::covers(const std::vector<fs::path> &dirs, const fs::path &path) {
+    const fs::path normal = fs::absolute(path).lexically_normal();
+    for (const fs::path &dir : dirs) {
+        const fs::path root = fs::absolute(dir).lexically_normal();
+        if (std::mismatch(root.begin(), root.end(), normal.begin(), normal.end()).first == root.end())
+            return true;
+    }
+    return false;
+}
+
+bool watch::changed(WatchContext *wctx) {
+    bool any = false;
+
+#ifdef __linux__
+    alignas(inotify_event) char buffer[BRV_PROC_BUFFER_SIZE];
+    while (true) {
+        const ssize_t size = read(wctx->notify, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR) continue;
+        if (size <= 0) break;
+
+        for (ssize_t i = 0; i < size; i += sizeof(inotify_event) + ((inotify_event *)(buffer + i))->len) {
+            const inotify_event *event = (const inotify_event *)(buffer + i);
+
+            // Dropped events could hide anything
+            if (event->mask & IN_Q_OVERFLOW) {
+                wctx->reload = any = true;
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                wctx->dirs.erase(event->wd);
+                continue;
+            }
+
+            const std::unordered_map<int, fs::path>::const_iterator it = wctx->dirs.find(event->wd);
+            if (it == wctx->dirs.end() || event->len == 0) continue;
+            const fs::path path = it->second / event->name;
+
+            if (wctx->roots.contains(it->second)) {
+                if (path.filename() != BRV_FILE_NAME_CONFIG) continue;
+                wctx->reload = any = true;
+                continue;
+            }
+
+            any = true;
+            wctx->changed.insert(path.lexically_normal());
+            if (event->mask & (IN_CLOSE_WRITE | IN_MODIFY)) {
+                wctx->dirty = true;
+                continue;
+            }
+
+            // Entries came or went, the source lists are checked once things settle
+            wctx->changed.insert(it->second.lexically_normal());
+            wctx->dirty = wctx->moved = true;
+            if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+                add(wctx, path, true);
+        }
+    }
+#else
+    std::unordered_map<fs::path, fs::file_time_type> files = snapshot(wctx);
+    for (const std::pair<const fs::path, fs::file_time_type> &pair : files) {
+        const std::unordered_map<fs::path, fs::file_time_type>::const_iterator it = wctx->files.find(pair.first);
+        if (it != wctx->files.end() && it->second == pair.second) continue;
+
+        any = wctx->dirty = true;
+        wctx->changed.insert(pair.first.lexically_normal());
+        if (pair.first.filename() == BRV_FILE_NAME_CONFIG && wctx->roots.contains(pair.first.parent_path()))
+            wctx->reload = true;
+        if (it == wctx->files.end())
+            wctx->moved = true;
+    }
+    for (const std::pair<const fs::path, fs::file_time_type> &pair : wctx->files)
+        if (!files.contains(pair.first)) {
+            any = wctx->dirty = wctx->moved = true;
+            wctx->changed.insert(pair.first.lexically_normal());
+        }
+    wctx->files = std::move(files);
+#endif
+
+    return any;
+}
+
+std::unordered_map<fs::path, fs::file_time_type> watch::snapshot(const WatchContext *wctx) {
+    std::unordered_map<fs::path, fs::file_time_type> files{};
+    for (const std::pair<const int, fs::path> &pair : wctx->dirs) {
+        if (wctx->roots.contains(pair.second)) {
+            const fs::path config = pair.second / BRV_FILE_NAME_CONFIG;
+            if (file::isfile(config)) files[config] = fs::last_write_time(config);
+            continue;
+        }
+        std::error_code error;
+        for (const fs::directory_entry &entry : fs::recursive_directory_iterator(pair.second, error))
+            if (entry.is_regular_file())
+                files[entry.path()] = entry.last_write_time();
+    }
+    return files;
+}
+
+bool watch::stale(const CmdContext *cctx) {
+    // Sources only change the plan when they are added or removed
+    const auto differs = [](const fs::path &dir, const std::vector<fs::path> &known) {
+        std::vector<fs::path> found{};
+        if (file::isdir(dir)) file::recurse(dir, found, BRV_FILE_EXT_CPP);
+        if (file::isdir(dir)) file::recurse(dir, found, BRV_FILE_EXT_MODULE);
+        std::vector<fs::path> sorted = known;
+        std::sort(found.begin(), found.end());
+        std::sort(sorted.begin(), sorted.end());
+        return found != sorted;
+    };
+
+    for (const ProjectContext *pctx : cctx->build_protocol) {
+        if (differs(pctx->build->src_dir, pctx->build->src_files)) return true;
+        if (differs(pctx->build->test_dir / BRV_DIR_SRC, pctx->build->test_src_files)) return true;
+    }
+    return false;
+}
+
+bool watch::intact(const CmdContext *cctx) {
+    // Outputs are not watched, one deleted since the last build has to be made again
+    for (const ProjectContext *pctx : cctx->build_protocol)
+        if (!file::isfile(pctx->build->end_dst) || !file::isfile(pctx->build->state->path))
+            return false;
+    for (const fs::path &test : cctx->active_project->build->test_exe_files)
+        if (!file::isfile(test))
+            return false;
+    return true;
+}
+
+void watch::serve(const CmdContext *cctx, WatchContext *wctx) {
+    const int client = accept(wctx->listen, nullptr, nullptr);
+    if (client < 0) return;
+    fcntl(client, F_SETFD, FD_CLOEXEC);
+
+    std::string line;
+    char ch;
+    while (read(client, &ch, 1) == 1 && ch != '\n')
+        line += ch;
+
+    // Events of a save that raced the request still count
+    changed(wctx);
+
+    std::istringstream request(line);
+    std::string name;
+    CmdContext copy = *cctx;
+    bool verbose = false, unity = false;
+    unsigned int jobs = 0;
+    double load = 0;
+    request >> name >> verbose >> jobs >> load >> unity;
+    if (jobs != 0) copy.jobs = jobs;
+    if (load > 0) copy.load = load;
+    copy.verbose = verbose;
+
+    // Unity builds lay out other objects and changes the daemon cannot apply in place need a restart, the client builds meanwhile
+    const bool mismatch = request.fail() || name != BRV_CMD_BUILD_STR || unity != cctx->unity;
+    const bool restart = !mismatch && (wctx->reload || (wctx->moved && stale(cctx)));
+
+    int status = BRV_WATCH_FALLBACK;
+    if (!mismatch && !restart && wctx->built && !wctx->dirty && intact(cctx)) {
+        status = EXIT_SUCCESS;
+    } else if (!mismatch && !restart) {
+        status = build(&copy, wctx, client);
+        wctx->dirty = wctx->moved = false;
+    }
+
+    const std::string trailer = std::string(1, '\0') + std::to_string(status);
+    BRV_UNUSED(write(client, trailer.data(), trailer.size()));
+    ::close(client);
+
+    if (restart) watch::restart(cctx, wctx);
+}
+
+int watch::build(const CmdContext *cctx, WatchContext *wctx, int out) {
+    // Whatever is written from here on belongs to the next build
+    std::set<fs::path> written = std::move(wctx->changed);
+    wctx->changed.clear();
+    invalidate(cctx, written);
+    const bool known = wctx->built;
+
+    std::cout.flush();
+    std::cerr.flush();
+
+    // Failed builds exit, so each one runs in a fork of the loaded daemon
+    const pid_t pid = fork();
+    BRV_ASSERT(pid >= 0, "Failed to fork the watch daemon : ", std::strerror(errno), ".");
+
+    if (pid == 0) {
+        if (out >= 0) {
+            dup2(out, STDOUT_FILENO);
+            dup2(out, STDERR_FILENO);
+        }
+        // Only a successful build is a baseline the recorded changes can be applied to
+        CmdContext copy = *cctx;
+        copy.changed = known ? &written : nullptr;
+        cmd::build(&copy);
+        std::cout.flush();
+        _exit(EXIT_SUCCESS);
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    status = WIFEXITED(status) ? WEXITSTATUS(status) : BRV_PROC_SIGNAL_BASE + WTERMSIG(status);
+
+    refresh(cctx);
+    wctx->built = status == EXIT_SUCCESS;
+    return status;
+}
+
+void watch::invalidate(const CmdContext *cctx, const std::set<fs::path> &changed) {
+    // Hashes and listings of written paths are dropped from memory, the build takes them again
+    for (const ProjectContext *pctx : cctx->projects)
+        for (const fs::path &path : changed) {
+            BuildState *state = pctx->build->state;
+            state->files.erase(path.string());
+            const std::unordered_map<std::string, DirRecord>::iterator it = state->dirs.find(path.string());
+            if (it != state->dirs.end()) it->second.mtime = 0;
+        }
+}
+
+void watch::refresh(const CmdContext *cctx) {
+    // Only states a build wrote back are read again, a no-op build leaves the daemon's as they are
+    for (const ProjectContext *pctx : cctx->projects)
+        if (file::stat(pctx->build->state->path).mtime != pctx->build->state->mtime)
+            state::reload(pctx->build->state);
+}
+
+void watch::restart(const CmdContext *cctx, WatchContext *wctx) {
+    BRV_INFO("Project layout changed, reloading!");
+    close(wctx);
+
+    std::vector<char *> argv{};
+    for (const std::string &arg : cctx->argv)
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    execvp(argv.front(), argv.data());
+    BRV_THROW("Failed to restart the watch daemon : ", std::strerror(errno), ".");
+}
+
+fs::path watch::socket(const fs::path &root, const std::string &profile) {
+    return root / BRV_DIR_OBJ / profile / BRV_FILE_NAME_SOCKET;
+}
@@ -0,0 +1,86 @@
+#include <bravo/bravo.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace brv;
+
+std::string read(const fs::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// Preprocessed source of the same code in a checkout at root, including a header of the dependency at dep
+CompileJob job(const fs::path &root, const fs::path &dep, const Argv &flags) {
+    CompileJob job{};
+    job.root = root;
+    job.src = root / BRV_DIR_SRC / "a.cpp";
+    job.obj = root / BRV_DIR_OBJ / "a.o";
+    job.flags = flags;
+    fs::create_directories(job.obj.parent_path());
+
+    std::ofstream pre(fs::path(job.obj).replace_extension(BRV_FILE_EXT_PRE));
+    pre << "# 1 \"" << job.src.string() << "\"" << std::endl;
+    pre << "# 1 \"" << (dep / "include/b.hpp").string() << "\" 1" << std::endl;
+    pre << "int b();" << std::endl;
+    pre << "# 2 \"" << job.src.string() << "\" 2" << std::endl;
+    pre << "int a() { return b(); }" << std::endl;
+    return job;
+}
+
+int main() {
+    std::string dir = (fs::temp_directory_path() / "bravo_cache.XXXXXX").string();
+    if (mkdtemp(dir.data()) == nullptr) return EXIT_FAILURE;
+    const fs::path root = dir;
+    const fs::path a = root / "a", b = root / "b";
+
+    bool ok = true;
+    const auto check = [&](bool condition, const std::string &what) {
+        if (!condition) std::cerr << "Failed : " << what << std::endl;
+        ok = ok && condition;
+    };
+
+    CacheContext cache{};
+    cache.dir = root / "cache";
+    cache.max_size = BRV_CACHE_DEFAULT_SIZE;
+    cache.compiler = hash::string("c++");
+
+    // Checkouts only differ by their location, dependencies included
+    const Argv release = {"-O2"}, debug = {"-O2", "-g"};
+    check(cache::key(&cache, job(a, a / "dep", release)) == cache::key(&cache, job(b, b / "dep", release)), "release keys match across roots");
+    check(cache::key(&cache, job(a, a / "dep", debug)) == cache::key(&cache, job(b, b / "dep", debug)), "debug keys match inside the mapped root");
+    check(cache::key(&cache, job(a, root / "dep_a", debug)) != cache::key(&cache, job(b, root / "dep_b", debug)),
+        "debug keys differ on headers outside the mapped root");
+    check(cache::key(&cache, job(a, root / "dep_a", release)) == cache::key(&cache, job(b, root / "dep_b", release)),
+        "release keys ignore headers outside the mapped root");
+    check(cache::key(&cache, job(a, a / "dep", release)) != cache::key(&cache, job(a, a / "dep", debug)), "flags change the key");
+    check(cache::key(&cache, job(a, a / "dep", {"-DA", "B"})) != cache::key(&cache, job(a, a / "dep", {"-DA B"})), "arguments are hashed apart");
+
+    const CompileJob first = job(a, a / "dep", release);
+    const uint64_t key = cache::key(&cache, first);
+    check(!file::isfile(fs::path(first.obj).replace_extension(BRV_FILE_EXT_PRE)), "key removes the preprocessed source");
+
+    // Miss in the first checkout, store its object
+    check(!cache::fetch(&cache, key, first.obj), "empty cache misses");
+    std::ofstream(first.obj) << "object";
+    cache::store(&cache, key, first.obj);
+    check(file::isfile(cache::entry(&cache, key)), "store creates the entry");
+
+    // Restored objects may share the entry's inode, an old one must stay old whoever fetches next
+    check(cache::fetch(&cache, key, first.obj) && read(first.obj) == "object", "first root hits");
+    const fs::file_time_type old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    fs::last_write_time(first.obj, old);
+    const CompileJob second = job(b, b / "dep", release);
+    check(cache::key(&cache, second) == key, "second root has the same key");
+    check(cache::fetch(&cache, key, second.obj) && read(second.obj) == "object", "second root hits");
+    check(fs::last_write_time(first.obj) == old, "fetch keeps the mtime of objects restored earlier");
+    check(file::isfile(fs::path(cache::entry(&cache, key)).replace_extension(BRV_CACHE_EXT_USED)), "fetch stamps the entry");
+    check(cache.hits == 2 && cache.misses == 1, "hits and misses are counted");
+
+    fs::remove_all(root);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,116 @@
+#include <bravo/bravo.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace brv;
+
+CmdContext *context() {
+    CmdContext *cctx = new CmdContext();
+    cctx->cmd = CMD_MAP.at(BRV_CMD_BUILD_STR);
+    cctx->cmd_name = BRV_CMD_BUILD_STR;
+    return cctx;
+}
+
+std::string read(const fs::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void write(const fs::path &path, const std::string &data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+}
+
+int main() {
+    std::string dir = (fs::temp_directory_path() / "bravo_snapshot.XXXXXX").string();
+    if (mkdtemp(dir.data()) == nullptr) return EXIT_FAILURE;
+    const fs::path root = fs::weakly_canonical(dir);
+    const fs::path app = root / BRV_BENCH_APP;
+
+    bool ok = true;
+    const auto check = [&](bool condition, const std::string &what) {
+        if (!condition) std::cerr << "Failed : " << what << std::endl;
+        ok = ok && condition;
+    };
+
+    // Configs written in the last instants are never snapshotted
+    bench::project(root, bench::name(0), {}, 1, false);
+    bench::project(root, BRV_BENCH_APP, {bench::name(0)}, 1, true);
+    for (const fs::path &project : {root / bench::name(0), app})
+        fs::last_write_time(project / BRV_FILE_NAME_CONFIG, fs::file_time_type::clock::now() - std::chrono::hours(1));
+
+    // Same graph the config files describe, the app first and its dependency built before it
+    CmdContext *fresh = context();
+    for (const fs::path &project : {app, root / bench::name(0)}) {
+        ProjectContext *pctx = fresh->projects.emplace_back(new ProjectContext());
+        pctx->config = new ConfigContext();
+        pctx->config->root = project;
+        pctx->config->project_name = project.filename().string();
+        pctx->config->build_name = project.filename().string();
+        pctx->build = new BuildContext();
+        pctx->build->include_dirs = {project / BRV_DIR_INCLUDE};
+    }
+    ConfigContext *cfg = fresh->projects.front()->config;
+    cfg->project_type = BRV_PROJECT_TYPE_EXEC;
+    cfg->entry = BRV_DEFAULT_ENTRY;
+    cfg->jobs = 4;
+    cfg->deps = {root / bench::name(0)};
+    cfg->profiles[BRV_PROFILE_RELEASE].opt = "3";
+    cfg->profiles[BRV_PROFILE_RELEASE].debug = false;
+    cfg->profiles[BRV_PROFILE_RELEASE].defines = {"NDEBUG"};
+    fresh->projects.back()->config->project_type = BRV_PROJECT_TYPE_STATIC;
+    fresh->active_project = fresh->projects.front();
+    fresh->build_protocol = {fresh->projects.back(), fresh->projects.front()};
+    snapshot::save(fresh);
+
+    const fs::path path = snapshot::path(app);
+    check(file::isfile(path), "snapshot written");
+
+    CmdContext *loaded = context();
+    check(snapshot::load(loaded, app), "round trip loads");
+    check(loaded->projects.size() == fresh->projects.size(), "round trip keeps every project");
+    check(loaded->build_protocol.size() == fresh->build_protocol.size(), "round trip keeps the build protocol");
+    for (size_t i = 0; ok && i < loaded->build_protocol.size(); ++i) {
+        const ConfigContext *a = fresh->build_protocol.at(i)->config;
+        const ConfigContext *b = loaded->build_protocol.at(i)->config;
+        check(a->root == b->root && a->project_name == b->project_name && a->project_type == b->project_type && a->entry == b->entry
+            && a->jobs == b->jobs && a->deps == b->deps, "round trip keeps config " + a->project_name);
+    }
+    check(loaded->active_project->config->project_name == BRV_BENCH_APP, "round trip keeps the active project");
+    check(ok && loaded->active_project->build->include_dirs == fresh->active_project->build->include_dirs, "round trip keeps include dirs");
+    const ProfileConfig &release = loaded->active_project->config->profiles[BRV_PROFILE_RELEASE];
+    check(release.opt == "3" && release.debug == false && release.defines == std::vector<std::string>{"NDEBUG"}, "round trip keeps profiles");
+
+    // Every truncation and a count larger than the file must be rejected without throwing
+    const std::string data = read(path);
+    for (size_t size = 0; size < data.size(); size += 7) {
+        write(path, data.substr(0, size));
+        check(!snapshot::load(context(), app), "truncated to " + std::to_string(size) + " bytes");
+    }
+
+    std::string huge = data;
+    const uint64_t count = UINT64_MAX / 2;
+    huge.replace(2 * sizeof(uint64_t), sizeof(count), reinterpret_cast<const char *>(&count), sizeof(count));
+    write(path, huge);
+    check(!snapshot::load(context(), app), "huge project count");
+
+    huge = data;
+    huge.replace(data.size() - sizeof(uint64_t) * (fresh->build_protocol.size() + 1), sizeof(count), reinterpret_cast<const char *>(&count), sizeof(count));
+    write(path, huge);
+    check(!snapshot::load(context(), app), "huge protocol count");
+
+    write(path, data);
+    check(snapshot::load(context(), app), "restored snapshot loads again");
+
+    // Any edit of a config invalidates the snapshot
+    fs::last_write_time(app / BRV_FILE_NAME_CONFIG, fs::file_time_type::clock::now());
+    check(!snapshot::load(context(), app), "edited config");
+
+    fs::remove_all(root);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
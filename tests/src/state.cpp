@@ -0,0 +1,134 @@
+#include <bravo/bravo.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace brv;
+
+std::string read(const fs::path &path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void write(const fs::path &path, const std::string &data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+}
+
+BuildState *reload(const fs::path &path) {
+    BuildState *state = new BuildState();
+    state->path = path;
+    state::load(state);
+    return state;
+}
+
+bool empty(const BuildState *state) {
+    return state->dirs.empty() && state->files.empty() && state->records.empty();
+}
+
+int main() {
+    std::string dir = (fs::temp_directory_path() / "bravo_state.XXXXXX").string();
+    if (mkdtemp(dir.data()) == nullptr) return EXIT_FAILURE;
+    const fs::path root = dir;
+    const fs::path path = root / BRV_DIR_OBJ / BRV_FILE_NAME_STATE;
+
+    bool ok = true;
+    const auto check = [&](bool condition, const std::string &what) {
+        if (!condition) std::cerr << "Failed : " << what << std::endl;
+        ok = ok && condition;
+    };
+
+    // Stats older than the racy window are the only ones kept
+    const int64_t old = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch() - std::chrono::hours(1)).count();
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    BuildState saved{};
+    saved.path = path;
+    saved.dirty = true;
+    saved.dirs["src"] = {old, true, {"a.cpp", "b.cpp"}, {"sub"}};
+    saved.dirs["unseen"] = {old, false, {"c.cpp"}, {}};
+    saved.files["src/a.cpp"] = {old, 12, 0x1234};
+    saved.files["src/b.cpp"] = {now, 34, 0x5678};
+    saved.records["obj/a.o"] = {1, 2, 3, 4, 5, old, {"src/a.cpp", "include/a.hpp"}};
+    saved.records["bin/app"] = {6, 7, 0, 0, 8, 0, {}};
+    state::save(&saved);
+    check(!saved.dirty && file::isfile(path), "state written");
+
+    BuildState *loaded = reload(path);
+    check(loaded->dirs.size() == 1 && loaded->dirs.contains("src"), "round trip keeps only seen directories");
+    const DirRecord &src = loaded->dirs["src"];
+    check(src.mtime == old && src.files == saved.dirs["src"].files && src.dirs == saved.dirs["src"].dirs, "round trip keeps listings");
+    check(loaded->files.size() == 1 && loaded->files["src/a.cpp"].hash == 0x1234 && loaded->files["src/a.cpp"].size == 12, "round trip drops racy hashes");
+    check(loaded->records.size() == 2, "round trip keeps every record");
+    const ActionRecord &obj = loaded->records["obj/a.o"];
+    check(obj.command == 1 && obj.content == 2 && obj.peak_rss == 3 && obj.cpu_ms == 4 && obj.duration_ms == 5 && obj.depfile == old,
+        "round trip keeps record fields");
+    check(obj.prereqs == saved.records["obj/a.o"].prereqs, "round trip keeps prereqs");
+    check(loaded->records["bin/app"].prereqs.empty(), "round trip keeps empty prereqs");
+
+    // Any damage must load as an empty state, never as a partial one
+    const std::string data = read(path);
+    for (size_t size = 0; size < data.size(); size += 5) {
+        write(path, data.substr(0, size));
+        check(empty(reload(path)), "truncated to " + std::to_string(size) + " bytes");
+    }
+
+    std::string damaged = data;
+    damaged[0] ^= 0xff;
+    write(path, damaged);
+    check(empty(reload(path)), "bad magic");
+
+    damaged = data;
+    damaged[sizeof(uint32_t)] ^= 0xff;
+    write(path, damaged);
+    check(empty(reload(path)), "bad version");
+
+    // First file entry pointing past the blob
+    damaged = data;
+    const uint32_t offset = UINT32_MAX;
+    damaged.replace(sizeof(StateHeader) + sizeof(StateDir), sizeof(offset), reinterpret_cast<const char *>(&offset), sizeof(offset));
+    write(path, damaged);
+    check(empty(reload(path)), "bad string offset");
+
+    // First record with prereqs running past the index table
+    damaged = data;
+    const uint32_t first = UINT32_MAX - 1;
+    for (size_t i = 0; i < 2; ++i)
+        damaged.replace(sizeof(StateHeader) + sizeof(StateDir) + sizeof(StateFile) + i * sizeof(StateRecord) + sizeof(uint32_t),
+            sizeof(first), reinterpret_cast<const char *>(&first), sizeof(first));
+    write(path, damaged);
+    check(empty(reload(path)), "bad index range");
+
+    damaged = data;
+    damaged.back() = 'x';
+    write(path, damaged);
+    check(empty(reload(path)), "unterminated blob");
+
+    write(path, data);
+    check(!empty(reload(path)), "restored state loads again");
+
+    // Links back to a parent directory are listed as neither file nor directory
+    const fs::path tree = root / BRV_DIR_SRC;
+    fs::create_directories(tree / "sub");
+    std::ofstream(tree / "a.cpp").close();
+    std::ofstream(tree / "sub" / "b.cpp").close();
+    fs::create_directory_symlink("..", tree / "sub" / "loop");
+    fs::create_symlink(tree / "a.cpp", tree / "sub" / "c.cpp");
+
+    BuildState scanned{};
+    std::vector<fs::path> sources{};
+    state::recurse(&scanned, tree, sources, {BRV_FILE_EXT_CPP});
+    std::sort(sources.begin(), sources.end());
+    check(sources == std::vector<fs::path>{tree / "a.cpp", tree / "sub" / "b.cpp", tree / "sub" / "c.cpp"}, "recurse skips linked directories");
+    check(scanned.dirs[(tree / "sub").string()].dirs.empty(), "recurse does not list linked directories");
+
+    fs::remove_all(root);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}